@@ -12,6 +12,7 @@
 
 #include <librevenge/librevenge.h>
 #include "libcdr_api.h"
+#include "CDRParseOptions.h"
 
 namespace libcdr
 {
@@ -22,6 +23,18 @@ public:
   static CDRAPI bool isSupported(librevenge::RVNGInputStream *input);
 
   static CDRAPI bool parse(librevenge::RVNGInputStream *input, librevenge::RVNGDrawingInterface *painter);
+
+  static CDRAPI bool parse(librevenge::RVNGInputStream *input, librevenge::RVNGDrawingInterface *painter, unsigned threadCount);
+
+  static CDRAPI bool parse(librevenge::RVNGInputStream *input, librevenge::RVNGDrawingInterface *painter, const CDRParseOptions &options);
+
+  static CDRAPI bool parsePages(librevenge::RVNGInputStream *input, librevenge::RVNGDrawingInterface *painter,
+                                unsigned firstPage, unsigned lastPage, unsigned threadCount = 1);
+
+  static CDRAPI bool parsePages(librevenge::RVNGInputStream *input, librevenge::RVNGDrawingInterface *painter,
+                                unsigned firstPage, unsigned lastPage, const CDRParseOptions &options);
+
+  static CDRAPI unsigned getPageCount(librevenge::RVNGInputStream *input);
 };
 
 } // namespace libcdr
@@ -0,0 +1,100 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libcdr project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef __CDRPARSECONTROL_H__
+#define __CDRPARSECONTROL_H__
+
+#include "libcdr_api.h"
+
+namespace libcdr
+{
+
+/**
+How a parse watched by a CDRParseControl ended.
+*/
+enum CDRParseResult
+{
+  CDR_PARSE_OK,            //!< the document was parsed
+  CDR_PARSE_FAILED,        //!< the document could not be parsed
+  CDR_PARSE_CANCELLED,     //!< the parse was cancelled
+  CDR_PARSE_TIME_LIMIT,    //!< the parse took longer than its time limit
+  CDR_PARSE_INFLATE_LIMIT, //!< the compressed data inflated to more than their limit
+  CDR_PARSE_POINT_LIMIT    //!< the paths held more points than their limit
+};
+
+class CDRParseControlImpl;
+
+/**
+Watches a parse, reporting its progress and stopping it when it is cancelled or
+goes over one of its limits. The parse then stops at the next record and returns
+false, and getResult tells why. A limit of 0 is no limit.
+
+A control watches one parse at a time. It is passed to the parse with the
+control member of CDRParseOptions.
+*/
+class CDRAPI CDRParseControl
+{
+public:
+  CDRParseControl();
+  virtual ~CDRParseControl();
+
+  /**
+  Called as the parse goes on. It may be called from the threads collecting the
+  pages, but never by two of them at once. An exception thrown by it cancels the
+  parse, as cancel does.
+  \param bytesDone The bytes of the document read so far, not counting the
+  inflated data
+  \param bytesTotal The size of the document
+  \param pagesDone The pages drawn so far
+  */
+  virtual void progress(unsigned long bytesDone, unsigned long bytesTotal, unsigned pagesDone);
+
+  /**
+  Stops the parse at its next record. It can be called from any thread. A parse
+  started with a cancelled control stops at once.
+  */
+  void cancel();
+  bool isCancelled() const;
+
+  /**
+  Limits the time of the parse, in milliseconds.
+  */
+  void setTimeLimit(unsigned long milliseconds);
+  unsigned long getTimeLimit() const;
+  /**
+  Limits the size of the data inflated from the compressed lists of the document.
+  */
+  void setInflateLimit(unsigned long bytes);
+  unsigned long getInflateLimit() const;
+  /**
+  Limits the number of points of all the paths drawn from the document.
+  */
+  void setPathPointLimit(unsigned long points);
+  unsigned long getPathPointLimit() const;
+
+  /**
+  Tells how the last parse watched by the control ended.
+  */
+  CDRParseResult getResult() const;
+
+private:
+  friend class CDRParseTracker;
+
+  CDRParseControl(const CDRParseControl &);
+  CDRParseControl &operator=(const CDRParseControl &);
+
+  void setResult(CDRParseResult result);
+
+  CDRParseControlImpl *m_impl;
+};
+
+} // namespace libcdr
+
+#endif //  __CDRPARSECONTROL_H__
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
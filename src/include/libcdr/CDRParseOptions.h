@@ -0,0 +1,75 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libcdr project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef __CDRPARSEOPTIONS_H__
+#define __CDRPARSEOPTIONS_H__
+
+namespace libcdr
+{
+
+class CDRParseControl;
+
+/**
+The features of a parse which can be turned off for a cheaper import.
+The default values give the full parse.
+*/
+struct CDRParseOptions
+{
+  CDRParseOptions()
+    : manageColors(true), analyseText(true), keepYAxisUp(true), geometryOnly(false), cacheRecords(false), threadCount(1),
+      control(nullptr) {}
+
+  /**
+  Converts the colors of the document to RGB, using its color profiles. Without it,
+  every color is black. It needs a library built with CRD_COLOR.
+  */
+  bool manageColors;
+  /**
+  Decodes the text of the document and the names of its fonts. Without it, the texts
+  are drawn empty. The decoding needs a library built with CRD_TEXT, and the text
+  styles of the txsm records one built with CRD_ANALYSIS_FONT.
+  */
+  bool analyseText;
+  /**
+  Keeps the y axis of the paths pointing up, as in the document, only moving them by
+  the height of the page. Without it, the paths are flipped upside down, to point
+  their y axis down like the texts and the bitmaps.
+  */
+  bool keepYAxisUp;
+  /**
+  Only reads the paths, the transforms and the page sizes of CDR documents. The
+  bitmaps, the patterns, the fonts, the texts, the color profiles and the style table
+  are skipped without being read, so the objects using them are left out or drawn
+  without their fill.
+  */
+  bool geometryOnly;
+  /**
+  Keeps the records read by the first pass over a CDR document, with the data of its
+  cmpr lists, so that the second pass neither reads the input nor inflates the lists
+  again. It is faster, but the whole inflated document then stays in memory until the
+  end of the parse, instead of only the cmpr list being read. parsePages and the
+  parses in several threads always keep them, as they need the page index they give.
+  */
+  bool cacheRecords;
+  /**
+  The maximal number of threads, or 0 to use as many threads as the hardware runs
+  at once. CMX documents are always parsed in a single thread.
+  */
+  unsigned threadCount;
+  /**
+  Reports the progress of the parse, and stops it when it is cancelled or goes over
+  its limits. It is not owned by the options.
+  */
+  CDRParseControl *control;
+};
+
+} // namespace libcdr
+
+#endif //  __CDRPARSEOPTIONS_H__
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -12,6 +12,7 @@
 
 #include <librevenge/librevenge.h>
 #include "libcdr_api.h"
+#include "CDRParseOptions.h"
 
 namespace libcdr
 {
@@ -22,6 +23,8 @@ public:
   static CDRAPI bool isSupported(librevenge::RVNGInputStream *input);
 
   static CDRAPI bool parse(librevenge::RVNGInputStream *input, librevenge::RVNGDrawingInterface *painter);
+
+  static CDRAPI bool parse(librevenge::RVNGInputStream *input, librevenge::RVNGDrawingInterface *painter, const CDRParseOptions &options);
 };
 
 } // namespace libcdr
@@ -10,6 +10,8 @@
 #ifndef __LIBCDR_H__
 #define __LIBCDR_H__
 
+#include "CDRParseOptions.h"
+#include "CDRParseControl.h"
 #include "CDRDocument.h"
 #include "CMXDocument.h"
 
@@ -20,6 +20,8 @@
 #ifndef RVNGSTREAM_H
 #define RVNGSTREAM_H
 
+#include <string.h>
+
 namespace librevenge
 {
 
@@ -92,6 +94,96 @@ public:
 	is beyond its end. In all other cases, it should be false.
 	*/
 	virtual bool isEnd() = 0;
+
+	/**
+	Reads bytes at a given location, without using or changing the current position.
+	\param offset The offset, from the beginning of the input stream, of the first byte to read.
+	\param numBytes Number of bytes desired to be read.
+	\param buffer The array receiving the bytes, which must be able to hold \c numBytes bytes.
+	\return The number of bytes read, which is less than \c numBytes if the end of the input stream is reached.
+	\return 0 if the input stream does not support positional reads, which is the default.
+	\note The implementations do not modify the input stream, so several threads can call
+	this function on the same input stream at the same time.
+	*/
+	virtual unsigned long readAt(unsigned long /* offset */, unsigned long /* numBytes */, unsigned char * /* buffer */) const
+	{
+		return 0;
+	}
+
+	/**
+	Creates an input stream reading the same data with its own current position.
+	\return Should be a pointer to a new RVNGInputStream positioned at the beginning of the data.
+	\return Should be 0 if the input stream can not be cloned, which is the default.
+	\note Like a substream, the clone may read its data from this input stream,
+	so it must not be used after this stream has been destroyed.
+	\note A clone can be read in another thread than this stream. The clones of
+	the OLE2 substreams and of the inflated zip members read their data with the
+	positional reads of their parent, so they are only returned when the parent
+	supports readAt().
+	*/
+	virtual RVNGInputStream *clone() const
+	{
+		return nullptr;
+	}
+
+	/**
+	Extracts a \c named stream like getSubStreamByName(), but lets the returned stream
+	read its data from this input stream when they are needed, instead of copying them.
+	It avoids holding a whole big substream in memory.
+	\return Should be a pointer to RVNGInputStream constructed from the \c named stream if it exists.
+	\return The default implementation returns getSubStreamByName(name).
+	\note The returned stream must not be used after this input stream has been destroyed.
+	*/
+	virtual RVNGInputStream *getOnDemandSubStreamByName(const char *name)
+	{
+		return getSubStreamByName(name);
+	}
+
+	/**
+	Gives access to the bytes following the current position, without moving it.
+	It lets a caller decode a whole array after a single bounds check.
+	\param minBytes The minimal number of bytes needed.
+	\param maxBytes The maximal number of bytes wanted.
+	\param numBytes Number of bytes available at the returned pointer, between \c minBytes and \c maxBytes.
+	\return A pointer to \c numBytes contiguous bytes, which stays valid until the next call to read() or seek().
+	\return 0 if less than \c minBytes bytes are available.
+	*/
+	const unsigned char *peekSpan(unsigned long minBytes, unsigned long maxBytes, unsigned long &numBytes)
+	{
+		numBytes = 0;
+		if (maxBytes < minBytes)
+			maxBytes = minBytes;
+		const unsigned char *data = read(maxBytes, numBytes);
+		if (numBytes)
+			seek(-long(numBytes), RVNG_SEEK_CUR);
+		if (!data || numBytes < minBytes)
+		{
+			numBytes = 0;
+			return nullptr;
+		}
+		return data;
+	}
+
+	/**
+	Copies bytes from the current position to a buffer.
+	\param buffer The array receiving the bytes, which must be able to hold \c numBytes bytes.
+	\param numBytes Number of bytes desired to be read.
+	\return The number of bytes read, which is less than \c numBytes only if the end of the input stream is reached.
+	*/
+	unsigned long readInto(unsigned char *buffer, unsigned long numBytes)
+	{
+		unsigned long bytes = 0;
+		while (bytes < numBytes)
+		{
+			unsigned long numBytesRead = 0;
+			const unsigned char *data = read(numBytes - bytes, numBytesRead);
+			if (!data || !numBytesRead)
+				break;
+			memcpy(buffer + bytes, data, numBytesRead);
+			bytes += numBytesRead;
+		}
+		return bytes;
+	}
 };
 
 }
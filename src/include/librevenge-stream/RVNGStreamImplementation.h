@@ -27,6 +27,8 @@
 namespace librevenge
 {
 
+class RVNGStreamBuffer;
+
 class RVNGFileStreamPrivate;
 
 class REVENGE_STREAM_API RVNGFileStream: public RVNGInputStream
@@ -39,6 +41,16 @@ public:
 	long tell();
 	int seek(long offset, RVNG_SEEK_TYPE seekType);
 	bool isEnd();
+	unsigned long readAt(unsigned long offset, unsigned long numBytes, unsigned char *buffer) const;
+	RVNGInputStream *clone() const;
+
+	/** Enables or disables reading ahead.
+
+		When it is enabled and the file is read sequentially, the next part
+		of the file is read in a background thread while the current one is
+		used. The reads following a seek elsewhere are done directly.
+	 */
+	void setReadAhead(bool readAhead);
 
 	bool isStructured();
 	unsigned subStreamCount();
@@ -46,6 +58,7 @@ public:
 	bool existsSubStream(const char *name);
 	RVNGInputStream *getSubStreamById(unsigned id);
 	RVNGInputStream *getSubStreamByName(const char *name);
+	RVNGInputStream *getOnDemandSubStreamByName(const char *name);
 
 private:
 	RVNGFileStreamPrivate *d;
@@ -53,18 +66,70 @@ private:
 	RVNGFileStream &operator=(const RVNGFileStream &); // assignment is not allowed
 };
 
+class RVNGMappedFileStreamPrivate;
+
+/** A file stream which maps the whole file into memory.
+
+	read() returns pointers directly into the mapping, so no data is
+	copied and seek()/tell() do not touch the file at all. The returned
+	pointers stay valid for the lifetime of the stream.
+ */
+class REVENGE_STREAM_API RVNGMappedFileStream: public RVNGInputStream
+{
+public:
+	explicit RVNGMappedFileStream(const char *filename);
+	~RVNGMappedFileStream();
+
+	const unsigned char *read(unsigned long numBytes, unsigned long &numBytesRead);
+	long tell();
+	int seek(long offset, RVNG_SEEK_TYPE seekType);
+	bool isEnd();
+	unsigned long readAt(unsigned long offset, unsigned long numBytes, unsigned char *buffer) const;
+	RVNGInputStream *clone() const;
+
+	bool isStructured();
+	unsigned subStreamCount();
+	const char *subStreamName(unsigned id);
+	bool existsSubStream(const char *name);
+	RVNGInputStream *getSubStreamById(unsigned id);
+	RVNGInputStream *getSubStreamByName(const char *name);
+	RVNGInputStream *getOnDemandSubStreamByName(const char *name);
+
+private:
+	RVNGMappedFileStreamPrivate *d;
+	friend class RVNGStreamBuffer;
+	RVNGMappedFileStream(const RVNGMappedFileStream &); // copy is not allowed
+	RVNGMappedFileStream &operator=(const RVNGMappedFileStream &); // assignment is not allowed
+};
+
 class RVNGStringStreamPrivate;
 
+/** A stream reading its content from memory.
+
+	The data are either copied, or shared with their owner, in which case
+	no copy is made at all.
+ */
 class REVENGE_STREAM_API RVNGStringStream: public RVNGInputStream
 {
 public:
 	RVNGStringStream(const unsigned char *data, const unsigned int dataSize);
+	/** Creates a stream reading the \c dataSize bytes at \c data, without copying them.
+
+		The stream and the streams sharing its data, like its clones and its
+		substreams, read \c data directly, so the data must not be modified
+		while any of them is alive. Once the last of them is destroyed,
+		\c release is called with \c owner, if it is not null. This lets the
+		caller either hand its buffer over or keep sharing it.
+	 */
+	RVNGStringStream(const unsigned char *data, unsigned long dataSize, void (*release)(void *), void *owner);
 	~RVNGStringStream();
 
 	const unsigned char *read(unsigned long numBytes, unsigned long &numBytesRead);
 	long tell();
 	int seek(long offset, RVNG_SEEK_TYPE seekType);
 	bool isEnd();
+	unsigned long readAt(unsigned long offset, unsigned long numBytes, unsigned char *buffer) const;
+	RVNGInputStream *clone() const;
 
 	bool isStructured();
 	unsigned subStreamCount();
@@ -72,9 +137,12 @@ public:
 	bool existsSubStream(const char *name);
 	RVNGInputStream *getSubStreamByName(const char *name);
 	RVNGInputStream *getSubStreamById(unsigned);
+	RVNGInputStream *getOnDemandSubStreamByName(const char *name);
 
 private:
+	explicit RVNGStringStream(RVNGStringStreamPrivate *data);
 	RVNGStringStreamPrivate *d;
+	friend class RVNGStreamBuffer;
 	RVNGStringStream(const RVNGStringStream &); // copy is not allowed
 	RVNGStringStream &operator=(const RVNGStringStream &); // assignment is not allowed
 };
@@ -0,0 +1,101 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libcdr project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "CDRBitmapStore.h"
+
+#include "libcdr_utils.h"
+
+namespace
+{
+
+/* The size of the converted images kept for the next pages */
+static const unsigned long MAX_CONVERTED_SIZE = 64 * 1024 * 1024;
+
+} // anonymous namespace
+
+libcdr::CDRBitmapStore::CDRBitmapStore()
+  : m_images(), m_bitmaps(), m_converted(), m_convertedIndex(), m_convertedSize(0), m_mutex()
+{
+}
+
+libcdr::CDRBitmapStore::~CDRBitmapStore()
+{
+}
+
+void libcdr::CDRBitmapStore::addImage(unsigned id, const librevenge::RVNGBinaryData &image)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  _remove(id);
+  m_images[id] = image;
+}
+
+void libcdr::CDRBitmapStore::addBitmap(unsigned id, const CDRBitmap &bitmap)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  _remove(id);
+  m_bitmaps[id] = std::make_shared<CDRBitmap>(bitmap);
+}
+
+bool libcdr::CDRBitmapStore::getImage(unsigned id, librevenge::RVNGBinaryData &image)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  const auto iterImage = m_images.find(id);
+  if (iterImage != m_images.end())
+  {
+    image = iterImage->second;
+    return true;
+  }
+  const auto iterConverted = m_convertedIndex.find(id);
+  if (iterConverted == m_convertedIndex.end())
+    return false;
+  m_converted.splice(m_converted.begin(), m_converted, iterConverted->second);
+  image = iterConverted->second->second;
+  return true;
+}
+
+std::shared_ptr<const libcdr::CDRBitmap> libcdr::CDRBitmapStore::getBitmap(unsigned id)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  const auto iter = m_bitmaps.find(id);
+  if (iter == m_bitmaps.end())
+    return std::shared_ptr<const CDRBitmap>();
+  return iter->second;
+}
+
+void libcdr::CDRBitmapStore::addConvertedImage(unsigned id, const librevenge::RVNGBinaryData &image)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  // another thread may have converted it meanwhile
+  if (m_convertedIndex.find(id) != m_convertedIndex.end() || image.size() > MAX_CONVERTED_SIZE)
+    return;
+  m_converted.push_front(std::make_pair(id, image));
+  m_convertedIndex[id] = m_converted.begin();
+  m_convertedSize += image.size();
+  while (m_convertedSize > MAX_CONVERTED_SIZE)
+  {
+    m_convertedSize -= m_converted.back().second.size();
+    m_convertedIndex.erase(m_converted.back().first);
+    m_converted.pop_back();
+  }
+}
+
+void libcdr::CDRBitmapStore::_remove(unsigned id)
+{
+  m_images.erase(id);
+  m_bitmaps.erase(id);
+  const auto iterConverted = m_convertedIndex.find(id);
+  if (iterConverted != m_convertedIndex.end())
+  {
+    m_convertedSize -= iterConverted->second->second.size();
+    m_converted.erase(iterConverted->second);
+    m_convertedIndex.erase(iterConverted);
+  }
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
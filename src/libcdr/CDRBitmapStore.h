@@ -0,0 +1,69 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libcdr project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef __CDRBITMAPSTORE_H__
+#define __CDRBITMAPSTORE_H__
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include <librevenge/librevenge.h>
+
+#include "CDRTypes.h"
+
+namespace libcdr
+{
+
+/* Keeps the bitmaps of a document until the pages draw them.
+
+   The bitmaps stored as BMP files are kept whole. The others are kept
+   as they were read, to be converted when a page needs them, and the
+   last converted images are kept up to a total size. Their pixels are
+   not copied when the data of their records are in memory, like the
+   inflated cmpr lists: the store then only keeps those data alive.
+
+   The threads collecting the pages share the store. */
+class CDRBitmapStore
+{
+public:
+  CDRBitmapStore();
+  ~CDRBitmapStore();
+
+  void addImage(unsigned id, const librevenge::RVNGBinaryData &image);
+  void addBitmap(unsigned id, const CDRBitmap &bitmap);
+
+  /* Finds a BMP file, stored whole or converted lately */
+  bool getImage(unsigned id, librevenge::RVNGBinaryData &image);
+  /* Finds a bitmap as read; returns 0 if there is none */
+  std::shared_ptr<const CDRBitmap> getBitmap(unsigned id);
+  /* Keeps the image converted from a bitmap */
+  void addConvertedImage(unsigned id, const librevenge::RVNGBinaryData &image);
+
+private:
+  CDRBitmapStore(const CDRBitmapStore &);
+  CDRBitmapStore &operator=(const CDRBitmapStore &);
+
+  void _remove(unsigned id);
+
+  std::map<unsigned, librevenge::RVNGBinaryData> m_images;
+  std::map<unsigned, std::shared_ptr<const CDRBitmap> > m_bitmaps;
+  /* The converted images, the last used first */
+  std::list<std::pair<unsigned, librevenge::RVNGBinaryData> > m_converted;
+  std::map<unsigned, std::list<std::pair<unsigned, librevenge::RVNGBinaryData> >::iterator> m_convertedIndex;
+  unsigned long m_convertedSize;
+  mutable std::mutex m_mutex;
+};
+
+} // namespace libcdr
+
+#endif // __CDRBITMAPSTORE_H__
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
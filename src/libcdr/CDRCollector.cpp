@@ -10,6 +10,7 @@
 #include "CDRCollector.h"
 
 #include <math.h>
+#include <algorithm>
 #include <stack>
 #include <string.h>
 
@@ -17,72 +18,130 @@
 #include <lcms2.h>
 #endif
 
-#include "CDRColorProfiles.h"
 #include "libcdr_utils.h"
 
-libcdr::CDRParserState::CDRParserState()
-  : m_bmps(), m_patterns(), m_vects(), m_pages(), m_documentPalette(), m_texts(),
+#ifndef DUMP_IMAGE
+#define DUMP_IMAGE 0
+#endif
+
+namespace
+{
+
+/* The colors converted by a document rarely go over a few hundreds,
+   except in the bitmaps, whose colors are only cached up to this */
+static const size_t MAX_COLOR_CACHE_SIZE = 64 * 1024;
+
+#ifdef CRD_COLOR
+/* The color models converted through the lcms transforms, which are
+   worth caching */
+static bool usesColorTransform(unsigned short colorModel)
+{
+  switch (colorModel)
+  {
+  case 0x01:
+  case 0x02:
+  case 0x03:
+  case 0x05:
+  case 0x0c:
+  case 0x11:
+  case 0x12:
+  case 0x15:
+    return true;
+  default:
+    return false;
+  }
+}
+#endif
+
+/* The pixels of each row of a bitmap, which the row data may cut short;
+   returns false if the bitmap cannot be converted */
+static bool getBitmapRowPixels(const libcdr::CDRBitmap &bitmap, unsigned &rowPixels)
+{
+  const unsigned width = bitmap.width;
+  const unsigned height = bitmap.height ? bitmap.height : 1;
+
+  auto tmpPixelSize = (unsigned)(height * width);
+  if (tmpPixelSize < (unsigned)height) // overflow
+    return false;
+
+  unsigned tmpDIBImageSize = tmpPixelSize * 4;
+  if (tmpPixelSize > tmpDIBImageSize) // overflow !!!
+    return false;
+
+  unsigned tmpDIBOffsetBits = 14 + 40;
+  unsigned tmpDIBFileSize = tmpDIBOffsetBits + tmpDIBImageSize;
+  if (tmpDIBImageSize > tmpDIBFileSize) // overflow !!!
+    return false;
+
+  // Cater for eventual padding
+  unsigned lineWidth = bitmap.bitmapSize / height;
+
+  if (bitmap.colorModel == 6)
+    rowPixels = (unsigned)std::min((unsigned long)width, (unsigned long)lineWidth * 8);
+  else if (bitmap.colorModel == 5 || !bitmap.palette.empty())
+    rowPixels = std::min(width, lineWidth);
+  else if (bitmap.bpp == 24 && lineWidth >= 3)
+    rowPixels = std::min(width, lineWidth / 3);
+  else if (bitmap.bpp == 32 && lineWidth >= 4)
+    rowPixels = std::min(width, lineWidth / 4);
+  else
+    return false;
+  return true;
+}
+
+} // anonymous namespace
+
+libcdr::CDRParserState::CDRParserState(const CDRParseOptions &options, CDRParseTracker *tracker)
+  : m_options(options), m_tracker(tracker), m_bmps(), m_patterns(), m_pages(), m_documentPalette(), m_texts(),
     m_styles(), m_fillStyles(), m_lineStyles()
 #ifdef CRD_COLOR
-    , m_colorTransformCMYK2RGB(nullptr), m_colorTransformLab2RGB(nullptr), m_colorTransformRGB2RGB(nullptr)
+    , m_colorTransformCMYK2RGB(), m_colorTransformLab2RGB(), m_colorTransformRGB2RGB()
 #endif
+    , m_colorCache(), m_colorCacheMutex(), m_colorCacheHits(0), m_colorCacheMisses(0)
 {
 #ifdef CRD_COLOR
-  cmsHPROFILE tmpRGBProfile = cmsCreate_sRGBProfile();
-  m_colorTransformRGB2RGB = cmsCreateTransform(tmpRGBProfile, TYPE_RGB_8, tmpRGBProfile, TYPE_RGB_8, INTENT_PERCEPTUAL, 0);
-  cmsHPROFILE tmpCMYKProfile = cmsOpenProfileFromMem(CMYK_icc, sizeof(CMYK_icc)/sizeof(CMYK_icc[0]));
-  m_colorTransformCMYK2RGB = cmsCreateTransform(tmpCMYKProfile, TYPE_CMYK_DBL, tmpRGBProfile, TYPE_RGB_8, INTENT_PERCEPTUAL, 0);
-  cmsHPROFILE tmpLabProfile = cmsCreateLab4Profile(nullptr);
-  m_colorTransformLab2RGB = cmsCreateTransform(tmpLabProfile, TYPE_Lab_DBL, tmpRGBProfile, TYPE_RGB_8, INTENT_PERCEPTUAL, 0);
-  cmsCloseProfile(tmpLabProfile);
-  cmsCloseProfile(tmpCMYKProfile);
-  cmsCloseProfile(tmpRGBProfile);
+  if (!m_options.manageColors)
+    return;
+  m_colorTransformRGB2RGB = getDefaultColorTransform(TYPE_RGB_8);
+  m_colorTransformCMYK2RGB = getDefaultColorTransform(TYPE_CMYK_DBL);
+  m_colorTransformLab2RGB = getDefaultColorTransform(TYPE_Lab_DBL);
 #endif
 }
 
 libcdr::CDRParserState::~CDRParserState()
 {
-#ifdef CRD_COLOR
-  if (m_colorTransformCMYK2RGB)
-    cmsDeleteTransform(m_colorTransformCMYK2RGB);
-  if (m_colorTransformLab2RGB)
-    cmsDeleteTransform(m_colorTransformLab2RGB);
-  if (m_colorTransformRGB2RGB)
-    cmsDeleteTransform(m_colorTransformRGB2RGB);
-#endif
+  CDR_DEBUG_MSG(("CDRParserState: %lu colors taken from the color cache, %lu converted\n", m_colorCacheHits, m_colorCacheMisses));
 }
 
 void libcdr::CDRParserState::setColorTransform(const std::vector<unsigned char> &profile)
 {
 #ifdef CRD_COLOR
-  if (profile.empty())
+  if (!m_options.manageColors || profile.empty())
     return;
-  cmsHPROFILE tmpProfile = cmsOpenProfileFromMem(&profile[0], cmsUInt32Number(profile.size()));
-  if (!tmpProfile)
-    return;
-  cmsHPROFILE tmpRGBProfile = cmsCreate_sRGBProfile();
-  cmsColorSpaceSignature signature = cmsGetColorSpace(tmpProfile);
-  switch (signature)
+  switch (getProfileColorSpace(profile))
   {
   case cmsSigCmykData:
   {
-    if (m_colorTransformCMYK2RGB)
-      cmsDeleteTransform(m_colorTransformCMYK2RGB);
-    m_colorTransformCMYK2RGB = cmsCreateTransform(tmpProfile, TYPE_CMYK_DBL, tmpRGBProfile, TYPE_RGB_8, INTENT_PERCEPTUAL, 0);
+    const CDRColorTransform transform = getColorTransform(profile, TYPE_CMYK_DBL);
+    if (!transform)
+      return;
+    m_colorTransformCMYK2RGB = transform;
   }
   break;
   case cmsSigRgbData:
   {
-    if (m_colorTransformRGB2RGB)
-      cmsDeleteTransform(m_colorTransformRGB2RGB);
-    m_colorTransformRGB2RGB = cmsCreateTransform(tmpProfile, TYPE_RGB_8, tmpRGBProfile, TYPE_RGB_8, INTENT_PERCEPTUAL, 0);
+    const CDRColorTransform transform = getColorTransform(profile, TYPE_RGB_8);
+    if (!transform)
+      return;
+    m_colorTransformRGB2RGB = transform;
   }
   break;
   default:
-    break;
+    return;
   }
-  cmsCloseProfile(tmpProfile);
-  cmsCloseProfile(tmpRGBProfile);
+  // the cached colors were converted by the previous transforms
+  std::lock_guard<std::mutex> lock(m_colorCacheMutex);
+  m_colorCache.clear();
 #endif
 }
 
@@ -132,15 +191,171 @@ unsigned libcdr::CDRParserState::getBMPColor(const CDRColor &color)
   }
 }
 
+void libcdr::CDRParserState::getBMPColors(unsigned colorModel, const unsigned *colors, unsigned count, unsigned char *pixels)
+{
+#ifdef CRD_COLOR
+  if (m_options.manageColors && _convertBMPColors(colorModel, colors, count, pixels))
+    return;
+#endif
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const unsigned color = getBMPColor(libcdr::CDRColor(colorModel, colors[i]));
+    pixels[4*i] = (unsigned char)(color & 0xff);
+    pixels[4*i+1] = (unsigned char)((color >> 8) & 0xff);
+    pixels[4*i+2] = (unsigned char)((color >> 16) & 0xff);
+    pixels[4*i+3] = (unsigned char)((color >> 24) & 0xff);
+  }
+}
+
+bool libcdr::CDRParserState::canConvertBitmap(const CDRBitmap &bitmap) const
+{
+  unsigned rowPixels = 0;
+  return getBitmapRowPixels(bitmap, rowPixels);
+}
+
+bool libcdr::CDRParserState::getBitmap(unsigned imageId, librevenge::RVNGBinaryData &image)
+{
+  if (m_bmps.getImage(imageId, image))
+    return true;
+  const std::shared_ptr<const CDRBitmap> bitmap = m_bmps.getBitmap(imageId);
+  if (!bitmap)
+    return false;
+  librevenge::RVNGBinaryData converted;
+  if (!_convertBitmap(*bitmap, converted))
+    return false;
+#if DUMP_IMAGE
+  librevenge::RVNGString filename;
+  filename.sprintf("bitmap%.8x.bmp", imageId);
+  FILE *f = fopen(filename.cstr(), "wb");
+  if (f)
+  {
+    const unsigned char *tmpBuffer = converted.getDataBuffer();
+    for (unsigned long k = 0; k < converted.size(); k++)
+      fprintf(f, "%c",tmpBuffer[k]);
+    fclose(f);
+  }
+#endif
+  m_bmps.addConvertedImage(imageId, converted);
+  image = converted;
+  return true;
+}
+
+bool libcdr::CDRParserState::_convertBitmap(const CDRBitmap &bmp, librevenge::RVNGBinaryData &image)
+{
+  const unsigned colorModel = bmp.colorModel;
+  const unsigned width = bmp.width;
+  unsigned height = bmp.height;
+  const unsigned bpp = bmp.bpp;
+  const std::vector<unsigned> &palette = bmp.palette;
+  const unsigned char *bitmap = bmp.bitmap.get();
+
+  unsigned rowPixels = 0;
+  if (!getBitmapRowPixels(bmp, rowPixels))
+    return false;
+  if (height == 0)
+    height = 1;
+
+  unsigned tmpDIBImageSize = height * width * 4;
+  unsigned tmpDIBOffsetBits = 14 + 40;
+  unsigned tmpDIBFileSize = tmpDIBOffsetBits + tmpDIBImageSize;
+
+  // Create DIB file header
+  writeU16(image, 0x4D42);  // Type
+  writeU32(image, tmpDIBFileSize); // Size
+  writeU16(image, 0); // Reserved1
+  writeU16(image, 0); // Reserved2
+  writeU32(image, tmpDIBOffsetBits); // OffsetBits
+
+  // Create DIB Info header
+  writeU32(image, 40); // Size
+
+  writeU32(image, width);  // Width
+  writeU32(image, height); // Height
+
+  writeU16(image, 1); // Planes
+  writeU16(image, 32); // BitCount
+  writeU32(image, 0); // Compression
+  writeU32(image, tmpDIBImageSize); // SizeImage
+  writeU32(image, 0); // XPelsPerMeter
+  writeU32(image, 0); // YPelsPerMeter
+  writeU32(image, 0); // ColorsUsed
+  writeU32(image, 0); // ColorsImportant
+
+  // Cater for eventual padding
+  unsigned lineWidth = bmp.bitmapSize / height;
+
+  /* The colors of 8-bit pixels are converted once, into a table of
+     their 4-byte pixels */
+  std::vector<unsigned char> colorTable;
+  if (colorModel == 5 || (colorModel != 6 && !palette.empty()))
+  {
+    std::vector<unsigned> colors;
+    if (colorModel == 5)
+    {
+      for (unsigned c = 0; c < 256; ++c)
+        colors.push_back(c);
+    }
+    else
+      colors.assign(palette.begin(), palette.begin() + std::min(palette.size(), (size_t)256));
+    colorTable.resize(colors.size() * 4);
+    getBMPColors(colorModel, &colors[0], (unsigned)colors.size(), &colorTable[0]);
+  }
+
+  const unsigned long rowSize = (unsigned long)rowPixels * 4;
+  std::vector<unsigned char> pixels(rowSize * height);
+  std::vector<unsigned> rowColors;
+  if (bpp == 24 || bpp == 32)
+    rowColors.resize(rowPixels);
+
+  for (unsigned j = 0; j < height && rowPixels; ++j)
+  {
+    const unsigned char *row = &bitmap[j*lineWidth];
+    unsigned char *output = &pixels[j*rowSize];
+    if (colorModel == 6)
+    {
+      for (unsigned k = 0; k < rowPixels; ++k)
+      {
+        const unsigned char c = (row[k >> 3] & (0x80 >> (k & 7))) ? 0xff : 0;
+        output[4*k] = c;
+        output[4*k+1] = c;
+        output[4*k+2] = c;
+        output[4*k+3] = 0;
+      }
+    }
+    else if (!colorTable.empty())
+    {
+      const auto lastColor = (unsigned)(colorTable.size() / 4 - 1);
+      for (unsigned k = 0; k < rowPixels; ++k)
+      {
+        const unsigned c = std::min((unsigned)row[k], lastColor);
+        memcpy(&output[4*k], &colorTable[4*c], 4);
+      }
+    }
+    else if (bpp == 24)
+    {
+      for (unsigned k = 0; k < rowPixels; ++k)
+        rowColors[k] = ((unsigned)row[3*k+2] << 16) | ((unsigned)row[3*k+1] << 8) | ((unsigned)row[3*k]);
+      getBMPColors(colorModel, &rowColors[0], rowPixels, output);
+    }
+    else
+    {
+      for (unsigned k = 0; k < rowPixels; ++k)
+        rowColors[k] = ((unsigned)row[4*k+3] << 24) | ((unsigned)row[4*k+2] << 16) | ((unsigned)row[4*k+1] << 8) | ((unsigned)row[4*k]);
+      getBMPColors(colorModel, &rowColors[0], rowPixels, output);
+    }
+  }
+  if (!pixels.empty())
+    image.append(&pixels[0], pixels.size());
+  return true;
+}
+
 unsigned libcdr::CDRParserState::_getRGBColor(const CDRColor &color)
 {
-  unsigned char red = 0;
-  unsigned char green = 0;
-  unsigned char blue = 0;
+  if (!m_options.manageColors)
+    return 0;
+#ifdef CRD_COLOR
   unsigned short colorModel(color.m_colorModel);
   unsigned colorValue(color.m_colorValue);
-
-#ifdef CRD_COLOR
   if (colorModel == 0x19) // Spot colour not handled in the parser
   {
     unsigned short colourIndex = colorValue & 0xffff;
@@ -152,6 +367,38 @@ unsigned libcdr::CDRParserState::_getRGBColor(const CDRColor &color)
     }
     // todo handle tint
   }
+  if (!usesColorTransform(colorModel))
+    return _convertColor(colorModel, colorValue);
+
+  const unsigned long long key = ((unsigned long long)colorModel << 32) | colorValue;
+  {
+    std::lock_guard<std::mutex> lock(m_colorCacheMutex);
+    const auto iter = m_colorCache.find(key);
+    if (iter != m_colorCache.end())
+    {
+      ++m_colorCacheHits;
+      return iter->second;
+    }
+  }
+  // the transforms are created without cache, so they need no lock
+  const unsigned rgb = _convertColor(colorModel, colorValue);
+  std::lock_guard<std::mutex> lock(m_colorCacheMutex);
+  ++m_colorCacheMisses;
+  if (m_colorCache.size() < MAX_COLOR_CACHE_SIZE)
+    m_colorCache[key] = rgb;
+  return rgb;
+#else
+  (void)color;
+  return 0;
+#endif
+}
+
+#ifdef CRD_COLOR
+unsigned libcdr::CDRParserState::_convertColor(unsigned short colorModel, unsigned colorValue) const
+{
+  unsigned char red = 0;
+  unsigned char green = 0;
+  unsigned char blue = 0;
   unsigned char col0 = colorValue & 0xff;
   unsigned char col1 = (colorValue & 0xff00) >> 8;
   unsigned char col2 = (colorValue & 0xff0000) >> 16;
@@ -360,7 +607,7 @@ unsigned libcdr::CDRParserState::_getRGBColor(const CDRColor &color)
       (double)col3
     };
     unsigned char rgb[3] = { 0, 0, 0 };
-    cmsDoTransform(m_colorTransformCMYK2RGB, cmyk, rgb, 1);
+    cmsDoTransform(m_colorTransformCMYK2RGB.get(), cmyk, rgb, 1);
     red = rgb[0];
     green = rgb[1];
     blue = rgb[2];
@@ -378,7 +625,7 @@ unsigned libcdr::CDRParserState::_getRGBColor(const CDRColor &color)
       (double)col3*100.0/255.0
     };
     unsigned char rgb[3] = { 0, 0, 0 };
-    cmsDoTransform(m_colorTransformCMYK2RGB, cmyk, rgb, 1);
+    cmsDoTransform(m_colorTransformCMYK2RGB.get(), cmyk, rgb, 1);
     red = rgb[0];
     green = rgb[1];
     blue = rgb[2];
@@ -397,7 +644,7 @@ unsigned libcdr::CDRParserState::_getRGBColor(const CDRColor &color)
   {
     unsigned char input[3] = { col2, col1, col0 };
     unsigned char output[3] = { 0, 0, 0 };
-    cmsDoTransform(m_colorTransformRGB2RGB, input, output, 1);
+    cmsDoTransform(m_colorTransformRGB2RGB.get(), input, output, 1);
     red = output[0];
     green = output[1];
     blue = output[2];
@@ -560,7 +807,7 @@ unsigned libcdr::CDRParserState::_getRGBColor(const CDRColor &color)
     Lab.a = (double)(signed char)col1;
     Lab.b = (double)(signed char)col2;
     unsigned char rgb[3] = { 0, 0, 0 };
-    cmsDoTransform(m_colorTransformLab2RGB, &Lab, rgb, 1);
+    cmsDoTransform(m_colorTransformLab2RGB.get(), &Lab, rgb, 1);
     red = rgb[0];
     green = rgb[1];
     blue = rgb[2];
@@ -574,7 +821,7 @@ unsigned libcdr::CDRParserState::_getRGBColor(const CDRColor &color)
     Lab.a = (double)((signed char)(col1 - 0x80));
     Lab.b = (double)((signed char)(col2 - 0x80));
     unsigned char rgb[3] = { 0, 0, 0 };
-    cmsDoTransform(m_colorTransformLab2RGB, &Lab, rgb, 1);
+    cmsDoTransform(m_colorTransformLab2RGB.get(), &Lab, rgb, 1);
     red = rgb[0];
     green = rgb[1];
     blue = rgb[2];
@@ -592,10 +839,91 @@ unsigned libcdr::CDRParserState::_getRGBColor(const CDRColor &color)
   default:
     break;
   }
-#endif
   return (unsigned)((red << 16) | (green << 8) | blue);
 }
 
+bool libcdr::CDRParserState::_convertBMPColors(unsigned colorModel, const unsigned *colors, unsigned count, unsigned char *pixels) const
+{
+  /* The bitmap models are mapped to the color models as in getBMPColor,
+     and the inputs are laid out as in _convertColor */
+  if (!count)
+    return true;
+  std::vector<unsigned char> rgb(3 * (size_t)count);
+  switch (colorModel)
+  {
+  // RGB
+  case 1:
+  case 10:
+  {
+    if (!m_colorTransformRGB2RGB)
+      return false;
+    std::vector<unsigned char> input(3 * (size_t)count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+      input[3*i] = (unsigned char)((colors[i] >> 16) & 0xff);
+      input[3*i+1] = (unsigned char)((colors[i] >> 8) & 0xff);
+      input[3*i+2] = (unsigned char)(colors[i] & 0xff);
+    }
+    cmsDoTransform(m_colorTransformRGB2RGB.get(), &input[0], &rgb[0], count);
+    break;
+  }
+  // CMYK 255
+  case 3:
+  {
+    if (!m_colorTransformCMYK2RGB)
+      return false;
+    std::vector<double> cmyk(4 * (size_t)count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+      cmyk[4*i] = (double)(colors[i] & 0xff)*100.0/255.0;
+      cmyk[4*i+1] = (double)((colors[i] >> 8) & 0xff)*100.0/255.0;
+      cmyk[4*i+2] = (double)((colors[i] >> 16) & 0xff)*100.0/255.0;
+      cmyk[4*i+3] = (double)((colors[i] >> 24) & 0xff)*100.0/255.0;
+    }
+    cmsDoTransform(m_colorTransformCMYK2RGB.get(), &cmyk[0], &rgb[0], count);
+    break;
+  }
+  // Lab
+  case 11:
+  {
+    if (!m_colorTransformLab2RGB)
+      return false;
+    std::vector<cmsCIELab> Lab(count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+      Lab[i].L = (double)(colors[i] & 0xff)*100.0/255.0;
+      Lab[i].a = (double)((signed char)((int)((colors[i] >> 8) & 0xff) - 0x80));
+      Lab[i].b = (double)((signed char)((int)((colors[i] >> 16) & 0xff) - 0x80));
+    }
+    cmsDoTransform(m_colorTransformLab2RGB.get(), &Lab[0], &rgb[0], count);
+    break;
+  }
+  default:
+    return false;
+  }
+  for (unsigned i = 0; i < count; ++i)
+  {
+    pixels[4*i] = rgb[3*i+2];
+    pixels[4*i+1] = rgb[3*i+1];
+    pixels[4*i+2] = rgb[3*i];
+    pixels[4*i+3] = 0;
+  }
+  return true;
+}
+#endif
+
+unsigned long libcdr::CDRParserState::getColorCacheHits() const
+{
+  std::lock_guard<std::mutex> lock(m_colorCacheMutex);
+  return m_colorCacheHits;
+}
+
+unsigned long libcdr::CDRParserState::getColorCacheMisses() const
+{
+  std::lock_guard<std::mutex> lock(m_colorCacheMutex);
+  return m_colorCacheMisses;
+}
+
 librevenge::RVNGString libcdr::CDRParserState::getRGBColorString(const libcdr::CDRColor &color)
 {
   librevenge::RVNGString tempString;
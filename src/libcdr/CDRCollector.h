@@ -11,16 +11,17 @@
 #define __CDRCOLLECTOR_H__
 
 #include <map>
+#include <mutex>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include <librevenge/librevenge.h>
 #include <librevenge-stream/librevenge-stream.h>
+#include <libcdr/CDRParseOptions.h>
 
-#ifdef CRD_COLOR
-#include <lcms2.h>
-#endif
-
+#include "CDRBitmapStore.h"
+#include "CDRColorTransforms.h"
 #include "CDRTypes.h"
 
 namespace libcdr
@@ -28,15 +29,18 @@ namespace libcdr
 
 class CDRPath;
 class CDRTransforms;
+class CDRParseTracker;
 
 class CDRParserState
 {
 public:
-  CDRParserState();
+  explicit CDRParserState(const CDRParseOptions &options = CDRParseOptions(), CDRParseTracker *tracker = nullptr);
   ~CDRParserState();
-  std::map<unsigned, librevenge::RVNGBinaryData> m_bmps;
+  const CDRParseOptions m_options;
+  /* Follows the parse for the control of the options, if there is one */
+  CDRParseTracker *const m_tracker;
+  CDRBitmapStore m_bmps;
   std::map<unsigned, CDRPattern> m_patterns;
-  std::map<unsigned, librevenge::RVNGBinaryData> m_vects;
   std::vector<CDRPage> m_pages;
   std::map<unsigned, CDRColor> m_documentPalette;
   std::map<unsigned, std::vector<CDRTextLine> > m_texts;
@@ -46,21 +50,49 @@ public:
 
   unsigned _getRGBColor(const CDRColor &color);
   unsigned getBMPColor(const CDRColor &color);
+  /* Converts a run of bitmap colors of one model, writing each as the
+     four little-endian bytes of its getBMPColor value */
+  void getBMPColors(unsigned colorModel, const unsigned *colors, unsigned count, unsigned char *pixels);
   librevenge::RVNGString getRGBColorString(const CDRColor &color);
+  bool canConvertBitmap(const CDRBitmap &bitmap) const;
+  /* The BMP file of a bitmap, converted if it was stored as read */
+  bool getBitmap(unsigned imageId, librevenge::RVNGBinaryData &image);
 
 #ifdef CRD_COLOR
-  cmsHTRANSFORM m_colorTransformCMYK2RGB;
-  cmsHTRANSFORM m_colorTransformLab2RGB;
-  cmsHTRANSFORM m_colorTransformRGB2RGB;
+  // shared with the other parses of the process
+  CDRColorTransform m_colorTransformCMYK2RGB;
+  CDRColorTransform m_colorTransformLab2RGB;
+  CDRColorTransform m_colorTransformRGB2RGB;
 #endif
 
   void setColorTransform(const std::vector<unsigned char> &profile);
   void setColorTransform(librevenge::RVNGInputStream *input);
   void getRecursedStyle(CDRStyle &style, unsigned styleId);
 
+  /* How many colors were found in the color cache, and how many had to
+     be converted */
+  unsigned long getColorCacheHits() const;
+  unsigned long getColorCacheMisses() const;
+
 private:
   CDRParserState(const CDRParserState &);
   CDRParserState &operator=(const CDRParserState &);
+
+  bool _convertBitmap(const CDRBitmap &bitmap, librevenge::RVNGBinaryData &image);
+
+#ifdef CRD_COLOR
+  unsigned _convertColor(unsigned short colorModel, unsigned colorValue) const;
+  /* Converts the colors through one call of their transform; returns
+     false if the model does not use a transform */
+  bool _convertBMPColors(unsigned colorModel, const unsigned *colors, unsigned count, unsigned char *pixels) const;
+#endif
+
+  /* The RGB values of the colors converted through the transforms, by
+     color model and value. It is cleared when a transform changes */
+  std::unordered_map<unsigned long long, unsigned> m_colorCache;
+  mutable std::mutex m_colorCacheMutex;
+  unsigned long m_colorCacheHits;
+  unsigned long m_colorCacheMisses;
 };
 
 class CDRCollector
@@ -87,7 +119,7 @@ public:
   virtual void collectPageSize(double width, double height, double offsetX, double offsetY) = 0;
   virtual void collectPolygonTransform(unsigned numAngles, unsigned nextPoint, double rx, double ry, double cx, double cy) = 0;
   virtual void collectBitmap(unsigned imageId, double x1, double x2, double y1, double y2) = 0;
-  virtual void collectBmp(unsigned imageId, unsigned colorModel, unsigned width, unsigned height, unsigned bpp, const std::vector<unsigned> &palette, const std::vector<unsigned char> &bitmap) = 0;
+  virtual void collectBmp(unsigned imageId, const CDRBitmap &bitmap) = 0;
   virtual void collectBmp(unsigned imageId, const std::vector<unsigned char> &bitmap) = 0;
   virtual void collectBmpf(unsigned patternId, unsigned width, unsigned height, const std::vector<unsigned char> &pattern) = 0;
   virtual void collectPpdt(const std::vector<std::pair<double, double> > &points, const std::vector<unsigned> &knotVector) = 0;
@@ -0,0 +1,138 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libcdr project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "CDRColorTransforms.h"
+
+#ifdef CRD_COLOR
+
+#include <mutex>
+#include <string.h>
+
+#include "CDRColorProfiles.h"
+#include "libcdr_utils.h"
+
+namespace
+{
+
+/* Documents rarely embed more than a couple of profiles, so the oldest
+   transforms are dropped once that many are kept */
+static const size_t MAX_SHARED_TRANSFORMS = 64;
+
+struct SharedTransform
+{
+  SharedTransform(size_t hash, cmsUInt32Number inputFormat, const std::vector<unsigned char> &profile, const libcdr::CDRColorTransform &transform)
+    : m_hash(hash), m_inputFormat(inputFormat), m_profile(profile), m_transform(transform) {}
+
+  size_t m_hash;
+  cmsUInt32Number m_inputFormat;
+  std::vector<unsigned char> m_profile;
+  libcdr::CDRColorTransform m_transform;
+};
+
+struct SharedTransforms
+{
+  SharedTransforms() : m_mutex(), m_transforms() {}
+
+  std::mutex m_mutex;
+  std::vector<SharedTransform> m_transforms;
+};
+
+SharedTransforms &getSharedTransforms()
+{
+  static SharedTransforms transforms;
+  return transforms;
+}
+
+// FNV-1a
+size_t hashProfile(const std::vector<unsigned char> &profile)
+{
+  unsigned long long hash = 0xcbf29ce484222325ULL;
+  for (unsigned char c : profile)
+  {
+    hash ^= c;
+    hash *= 0x100000001b3ULL;
+  }
+  return size_t(hash);
+}
+
+/* Takes the input profile */
+libcdr::CDRColorTransform createTransform(cmsHPROFILE inputProfile, cmsUInt32Number inputFormat)
+{
+  if (!inputProfile)
+    return libcdr::CDRColorTransform();
+  cmsHPROFILE rgbProfile = cmsCreate_sRGBProfile();
+  cmsHTRANSFORM transform = cmsCreateTransform(inputProfile, inputFormat, rgbProfile, TYPE_RGB_8, INTENT_PERCEPTUAL, cmsFLAGS_NOCACHE);
+  cmsCloseProfile(rgbProfile);
+  cmsCloseProfile(inputProfile);
+  if (!transform)
+    return libcdr::CDRColorTransform();
+  return libcdr::CDRColorTransform(transform, cmsDeleteTransform);
+}
+
+} // anonymous namespace
+
+libcdr::CDRColorTransform libcdr::getDefaultColorTransform(cmsUInt32Number inputFormat)
+{
+  switch (inputFormat)
+  {
+  case TYPE_RGB_8:
+  {
+    static const CDRColorTransform transform(createTransform(cmsCreate_sRGBProfile(), TYPE_RGB_8));
+    return transform;
+  }
+  case TYPE_CMYK_DBL:
+  {
+    static const CDRColorTransform transform(createTransform(cmsOpenProfileFromMem(CMYK_icc, sizeof(CMYK_icc)/sizeof(CMYK_icc[0])), TYPE_CMYK_DBL));
+    return transform;
+  }
+  case TYPE_Lab_DBL:
+  {
+    static const CDRColorTransform transform(createTransform(cmsCreateLab4Profile(nullptr), TYPE_Lab_DBL));
+    return transform;
+  }
+  default:
+    return CDRColorTransform();
+  }
+}
+
+libcdr::CDRColorTransform libcdr::getColorTransform(const std::vector<unsigned char> &profile, cmsUInt32Number inputFormat)
+{
+  if (profile.empty())
+    return CDRColorTransform();
+  const size_t hash = hashProfile(profile);
+  SharedTransforms &shared = getSharedTransforms();
+  std::lock_guard<std::mutex> lock(shared.m_mutex);
+  for (const auto &iter : shared.m_transforms)
+  {
+    if (iter.m_hash == hash && iter.m_inputFormat == inputFormat && iter.m_profile.size() == profile.size()
+        && !memcmp(&iter.m_profile[0], &profile[0], profile.size()))
+      return iter.m_transform;
+  }
+  const CDRColorTransform transform = createTransform(cmsOpenProfileFromMem(&profile[0], cmsUInt32Number(profile.size())), inputFormat);
+  if (!transform)
+    return transform;
+  if (shared.m_transforms.size() >= MAX_SHARED_TRANSFORMS)
+    shared.m_transforms.erase(shared.m_transforms.begin());
+  shared.m_transforms.push_back(SharedTransform(hash, inputFormat, profile, transform));
+  CDR_DEBUG_MSG(("getColorTransform: %lu transforms shared\n", (unsigned long)shared.m_transforms.size()));
+  return transform;
+}
+
+cmsColorSpaceSignature libcdr::getProfileColorSpace(const std::vector<unsigned char> &profile)
+{
+  // the big-endian signature at offset 16 of the profile header
+  if (profile.size() < 20)
+    return cmsColorSpaceSignature(0);
+  return cmsColorSpaceSignature(((unsigned)profile[16] << 24) | ((unsigned)profile[17] << 16)
+                                | ((unsigned)profile[18] << 8) | (unsigned)profile[19]);
+}
+
+#endif // CRD_COLOR
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
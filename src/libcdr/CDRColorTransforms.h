@@ -0,0 +1,46 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libcdr project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef __CDRCOLORTRANSFORMS_H__
+#define __CDRCOLORTRANSFORMS_H__
+
+#ifdef CRD_COLOR
+
+#include <memory>
+#include <vector>
+
+#include <lcms2.h>
+
+namespace libcdr
+{
+
+/* A transform to sRGB in TYPE_RGB_8, deleted when its last user lets it
+   go. The transforms are created without cache, so that several threads
+   can use them at once. */
+typedef std::shared_ptr<void> CDRColorTransform;
+
+/* The transform from one of TYPE_RGB_8 (sRGB), TYPE_CMYK_DBL (the generic
+   CMYK profile) or TYPE_Lab_DBL (Lab D50), created once per process */
+CDRColorTransform getDefaultColorTransform(cmsUInt32Number inputFormat);
+
+/* The transform from an ICC profile. The transforms are shared by all
+   the parses of the process, keyed by the bytes of their profile and
+   their input format. Returns an empty transform if lcms does not take
+   the profile. */
+CDRColorTransform getColorTransform(const std::vector<unsigned char> &profile, cmsUInt32Number inputFormat);
+
+/* The color space of an ICC profile, read from its header */
+cmsColorSpaceSignature getProfileColorSpace(const std::vector<unsigned char> &profile);
+
+} // namespace libcdr
+
+#endif // CRD_COLOR
+
+#endif // __CDRCOLORTRANSFORMS_H__
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -14,6 +14,7 @@
 #include <librevenge/librevenge.h>
 #include <libcdr/libcdr.h>
 #include "CDROutputElementList.h"
+#include "CDRParseTracker.h"
 #include "libcdr_utils.h"
 
 #ifndef DUMP_PATTERN
@@ -24,7 +25,6 @@
 #define DUMP_VECT 0
 #endif
 
-#define CDR_DOC_UPDOWN_FLIP_ENABLE
 namespace libcdr
 {
 namespace
@@ -71,7 +71,7 @@ libcdr::CDRContentCollector::CDRContentCollector(libcdr::CDRParserState &ps, lib
     m_outputElementsStack(nullptr), m_contentOutputElementsStack(), m_fillOutputElementsStack(),
     m_outputElementsQueue(nullptr), m_contentOutputElementsQueue(), m_fillOutputElementsQueue(),
     m_groupLevels(), m_groupTransforms(), m_splineData(), m_fillOpacity(1.0), m_reverseOrder(reverseOrder),
-    m_ps(ps)
+    m_vects(), m_patternBitmaps(), m_ps(ps)
 {
   m_outputElementsStack = &m_contentOutputElementsStack;
   m_outputElementsQueue = &m_contentOutputElementsQueue;
@@ -137,6 +137,14 @@ void libcdr::CDRContentCollector::_endPage()
   if (m_painter)
     m_painter->endPage();
   m_isPageStarted = false;
+  if (m_ps.m_tracker)
+    m_ps.m_tracker->endPage();
+}
+
+void libcdr::CDRContentCollector::setPageIndex(unsigned pageIndex)
+{
+  if (pageIndex < m_ps.m_pages.size())
+    m_pageIndex = pageIndex;
 }
 
 void libcdr::CDRContentCollector::collectPage(unsigned level)
@@ -144,7 +152,9 @@ void libcdr::CDRContentCollector::collectPage(unsigned level)
   m_isPageProperties = true;
   m_ignorePage = false;
   m_currentPageLevel = level;
-  m_page = m_ps.m_pages[m_pageIndex++];
+  if (m_pageIndex < m_ps.m_pages.size())
+    m_page = m_ps.m_pages[m_pageIndex];
+  ++m_pageIndex;
 
 }
 
@@ -245,17 +255,20 @@ void libcdr::CDRContentCollector::_flushCurrentPath()
       m_currentPath.transform(m_groupTransforms.top());
     CDRTransform tmpTrafo(1.0, 0.0, -m_page.offsetX, 0.0, 1.0, -m_page.offsetY);
     m_currentPath.transform(tmpTrafo);
-	#ifdef CDR_DOC_UPDOWN_FLIP_ENABLE
-    tmpTrafo = CDRTransform(1.0, 0.0, 0.0, 0.0, 1.0, m_page.height);
-	#else
-    tmpTrafo = CDRTransform(1.0, 0.0, 0.0, 0.0, -1.0, m_page.height);
-	#endif
+    if (m_ps.m_options.keepYAxisUp)
+      tmpTrafo = CDRTransform(1.0, 0.0, 0.0, 0.0, 1.0, m_page.height);
+    else
+      tmpTrafo = CDRTransform(1.0, 0.0, 0.0, 0.0, -1.0, m_page.height);
     m_currentPath.transform(tmpTrafo);
 
     std::vector<librevenge::RVNGPropertyList> tmpPath;
 
     librevenge::RVNGPropertyListVector path;
     m_currentPath.writeOut(path);
+    // every shape ends here, the rectangles and the ellipses too, so
+    // their points are counted here rather than by the parsers
+    if (m_ps.m_tracker && !m_ps.m_tracker->addPathPoints(path.count()))
+      path.clear();
 
     bool isPathClosed = m_currentPath.isClosed();
 
@@ -612,7 +625,7 @@ void libcdr::CDRContentCollector::collectLevel(unsigned level)
         "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>\n<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\" \"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">\n";
       librevenge::RVNGBinaryData output((const unsigned char *)header, strlen(header));
       output.append((unsigned char *)svgOutput[0].cstr(), strlen(svgOutput[0].cstr()));
-      m_ps.m_vects[m_spnd] = output;
+      m_vects[m_spnd] = output;
     }
 #if DUMP_VECT
     librevenge::RVNGString filename;
@@ -620,8 +633,8 @@ void libcdr::CDRContentCollector::collectLevel(unsigned level)
     FILE *f = fopen(filename.cstr(), "wb");
     if (f)
     {
-      const unsigned char *tmpBuffer = m_ps.m_vects[m_spnd].getDataBuffer();
-      for (unsigned long k = 0; k < m_ps.m_vects[m_spnd].size(); k++)
+      const unsigned char *tmpBuffer = m_vects[m_spnd].getDataBuffer();
+      for (unsigned long k = 0; k < m_vects[m_spnd].size(); k++)
         fprintf(f, "%c",tmpBuffer[k]);
       fclose(f);
     }
@@ -637,7 +650,7 @@ void libcdr::CDRContentCollector::collectLevel(unsigned level)
     m_currentVectLevel = 0;
     m_outputElementsStack = &m_contentOutputElementsStack;
     m_outputElementsQueue = &m_contentOutputElementsQueue;
-    m_page = m_ps.m_pages[m_pageIndex ? m_pageIndex-1 : 0];
+    m_page = m_ps.m_pages[std::min<size_t>(m_pageIndex ? m_pageIndex-1 : 0, m_ps.m_pages.size()-1)];
   }
   if (level <= m_currentPageLevel)
   {
@@ -795,8 +808,16 @@ void libcdr::CDRContentCollector::_fillProperties(librevenge::RVNGPropertyList &
         if (iterPattern != m_ps.m_patterns.end())
         {
           propList.insert("draw:fill", "bitmap");
-          librevenge::RVNGBinaryData image;
-          _generateBitmapFromPattern(image, iterPattern->second, m_currentFillStyle.color1, m_currentFillStyle.color2);
+          const auto key = std::make_tuple(m_currentFillStyle.imageFill.id, m_ps._getRGBColor(m_currentFillStyle.color1),
+                                           m_ps._getRGBColor(m_currentFillStyle.color2));
+          auto iterBitmap = m_patternBitmaps.find(key);
+          if (iterBitmap == m_patternBitmaps.end())
+          {
+            librevenge::RVNGBinaryData bitmap;
+            _generateBitmapFromPattern(bitmap, iterPattern->second, std::get<1>(key), std::get<2>(key));
+            iterBitmap = m_patternBitmaps.insert(std::make_pair(key, bitmap)).first;
+          }
+          const librevenge::RVNGBinaryData &image = iterBitmap->second;
 #if DUMP_PATTERN
           librevenge::RVNGString filename;
           filename.sprintf("pattern%.8x.bmp", m_currentFillStyle.imageFill.id);
@@ -865,12 +886,12 @@ void libcdr::CDRContentCollector::_fillProperties(librevenge::RVNGPropertyList &
       case 9: // Bitmap
       case 11: // Texture
       {
-        auto iterBmp = m_ps.m_bmps.find(m_currentFillStyle.imageFill.id);
-        if (iterBmp != m_ps.m_bmps.end())
+        librevenge::RVNGBinaryData image;
+        if (m_ps.getBitmap(m_currentFillStyle.imageFill.id, image))
         {
           propList.insert("librevenge:mime-type", "image/bmp");
           propList.insert("draw:fill", "bitmap");
-          propList.insert("draw:fill-image", iterBmp->second);
+          propList.insert("draw:fill-image", image);
           propList.insert("style:repeat", "repeat");
           if (m_currentFillStyle.imageFill.isRelative)
           {
@@ -925,8 +946,8 @@ void libcdr::CDRContentCollector::_fillProperties(librevenge::RVNGPropertyList &
       break;
       case 10: // Full color
       {
-        auto iterVect = m_ps.m_vects.find(m_currentFillStyle.imageFill.id);
-        if (iterVect != m_ps.m_vects.end())
+        auto iterVect = m_vects.find(m_currentFillStyle.imageFill.id);
+        if (iterVect != m_vects.end())
         {
           propList.insert("draw:fill", "bitmap");
           propList.insert("librevenge:mime-type", "image/svg+xml");
@@ -1145,7 +1166,7 @@ void libcdr::CDRContentCollector::_lineProperties(librevenge::RVNGPropertyList &
 
 }
 
-void libcdr::CDRContentCollector::_generateBitmapFromPattern(librevenge::RVNGBinaryData &bitmap, const CDRPattern &pattern, const CDRColor &fgColor, const CDRColor &bgColor)
+void libcdr::CDRContentCollector::_generateBitmapFromPattern(librevenge::RVNGBinaryData &bitmap, const CDRPattern &pattern, unsigned foreground, unsigned background)
 {
   unsigned height = pattern.height;
   unsigned width = pattern.width;
@@ -1156,6 +1177,8 @@ void libcdr::CDRContentCollector::_generateBitmapFromPattern(librevenge::RVNGBin
   unsigned tmpDIBImageSize = tmpPixelSize * 4;
   if (tmpPixelSize > tmpDIBImageSize) // overflow !!!
     return;
+  if ((unsigned long long)width * height * 4 != tmpDIBImageSize) // overflow
+    return;
 
   unsigned tmpDIBOffsetBits = 14 + 40;
   unsigned tmpDIBFileSize = tmpDIBOffsetBits + tmpDIBImageSize;
@@ -1187,40 +1210,53 @@ void libcdr::CDRContentCollector::_generateBitmapFromPattern(librevenge::RVNGBin
   // The Bitmaps in CDR are padded to 32bit border
   unsigned lineWidth = (width + 7) / 8;
 
-  unsigned foreground = m_ps._getRGBColor(fgColor);
-  unsigned background = m_ps._getRGBColor(bgColor);
+  /* The pixels of the 16 values of 4 bits, the highest bit first. A set
+     bit is the background */
+  unsigned char nibblePixels[16][16];
+  for (unsigned n = 0; n < 16; ++n)
+  {
+    for (unsigned l = 0; l < 4; ++l)
+    {
+      const unsigned color = (n & (0x8 >> l)) ? background : foreground;
+      nibblePixels[n][4*l] = (unsigned char)(color & 0xff);
+      nibblePixels[n][4*l+1] = (unsigned char)((color >> 8) & 0xff);
+      nibblePixels[n][4*l+2] = (unsigned char)((color >> 16) & 0xff);
+      nibblePixels[n][4*l+3] = (unsigned char)((color >> 24) & 0xff);
+    }
+  }
 
+  std::vector<unsigned char> pixels((unsigned long)tmpDIBImageSize);
+  unsigned char *output = pixels.data();
   for (unsigned j = height; j > 0; --j)
   {
-    unsigned i = 0;
+    const unsigned long rowStart = (unsigned long)(j-1)*lineWidth;
     unsigned k = 0;
-    while (i <lineWidth && k < width)
+    for (unsigned i = 0; i < lineWidth && k < width; ++i)
     {
-      unsigned l = 0;
-      unsigned char c = 0;
-      const unsigned index = (j-1)*lineWidth+i;
-      if (index < pattern.pattern.size())
-        c = pattern.pattern[index];
-      i++;
-      while (k < width && l < 8)
+      const unsigned char c = rowStart + i < pattern.pattern.size() ? pattern.pattern[rowStart + i] : 0;
+      if (width - k >= 8)
       {
-        if (c & 0x80)
-          writeU32(bitmap, (int)background);
-        else
-          writeU32(bitmap, (int)foreground);
-        c <<= 1;
-        l++;
-        k++;
+        memcpy(output, nibblePixels[c >> 4], 16);
+        memcpy(output + 16, nibblePixels[c & 0xf], 16);
+        output += 32;
+        k += 8;
+      }
+      else
+      {
+        for (unsigned l = 0; k < width; ++l, ++k, output += 4)
+          memcpy(output, &nibblePixels[l < 4 ? c >> 4 : c & 0xf][4*(l & 3)], 4);
       }
     }
   }
+  if (!pixels.empty())
+    bitmap.append(pixels.data(), pixels.size());
 }
 
 void libcdr::CDRContentCollector::collectBitmap(unsigned imageId, double x1, double x2, double y1, double y2)
 {
-  auto iter = m_ps.m_bmps.find(imageId);
-  if (iter != m_ps.m_bmps.end())
-    m_currentImage = CDRImage(iter->second, x1, x2, y1, y2);
+  librevenge::RVNGBinaryData image;
+  if (m_ps.getBitmap(imageId, image))
+    m_currentImage = CDRImage(image, x1, x2, y1, y2);
 }
 
 void libcdr::CDRContentCollector::collectPpdt(const std::vector<std::pair<double, double> > &points, const std::vector<unsigned> &knotVector)
@@ -1274,7 +1310,7 @@ void libcdr::CDRContentCollector::collectVectorPattern(unsigned id, const librev
       "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>\n<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\" \"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">\n";
     librevenge::RVNGBinaryData output((const unsigned char *)header, strlen(header));
     output.append((unsigned char *)svgOutput[0].cstr(), strlen(svgOutput[0].cstr()));
-    m_ps.m_vects[id] = output;
+    m_vects[id] = output;
   }
 #if DUMP_VECT
   librevenge::RVNGString filename;
@@ -1291,8 +1327,8 @@ void libcdr::CDRContentCollector::collectVectorPattern(unsigned id, const librev
   f = fopen(filename.cstr(), "wb");
   if (f)
   {
-    const unsigned char *tmpBuffer = m_ps.m_vects[id].getDataBuffer();
-    for (unsigned long k = 0; k < m_ps.m_vects[id].size(); k++)
+    const unsigned char *tmpBuffer = m_vects[id].getDataBuffer();
+    for (unsigned long k = 0; k < m_vects[id].size(); k++)
       fprintf(f, "%c",tmpBuffer[k]);
     fclose(f);
   }
@@ -16,6 +16,7 @@
 #include <vector>
 #include <stack>
 #include <queue>
+#include <tuple>
 
 #include <librevenge/librevenge.h>
 
@@ -34,6 +35,10 @@ public:
   CDRContentCollector(CDRParserState &ps, librevenge::RVNGDrawingInterface *painter, bool reverseOrder = true);
   ~CDRContentCollector() override;
 
+  /* Makes the next page list met be the page pageIndex of the parser
+     state, for the parses which start after the first page */
+  void setPageIndex(unsigned pageIndex);
+
   // collector functions
   void collectPage(unsigned level) override;
   void collectObject(unsigned level) override;
@@ -52,7 +57,7 @@ public:
   void collectPageSize(double, double, double, double) override {}
   void collectPolygonTransform(unsigned numAngles, unsigned nextPoint, double rx, double ry, double cx, double cy) override;
   void collectBitmap(unsigned imageId, double x1, double x2, double y1, double y2) override;
-  void collectBmp(unsigned, unsigned, unsigned, unsigned, unsigned, const std::vector<unsigned> &, const std::vector<unsigned char> &) override {}
+  void collectBmp(unsigned, const CDRBitmap &) override {}
   void collectBmp(unsigned, const std::vector<unsigned char> &) override {}
   void collectBmpf(unsigned, unsigned, unsigned, const std::vector<unsigned char> &) override {}
   void collectPpdt(const std::vector<std::pair<double, double> > &points, const std::vector<unsigned> &knotVector) override;
@@ -85,7 +90,7 @@ private:
 
   void _fillProperties(librevenge::RVNGPropertyList &propList);
   void _lineProperties(librevenge::RVNGPropertyList &propList);
-  void _generateBitmapFromPattern(librevenge::RVNGBinaryData &bitmap, const CDRPattern &pattern, const CDRColor &fgColor, const CDRColor &bgColor);
+  void _generateBitmapFromPattern(librevenge::RVNGBinaryData &bitmap, const CDRPattern &pattern, unsigned foreground, unsigned background);
 
   librevenge::RVNGDrawingInterface *m_painter;
 
@@ -123,6 +128,13 @@ private:
   double m_fillOpacity;
   bool m_reverseOrder;
 
+  // the vector patterns rendered by this collector, so that the parser
+  // state is only read while the pages are collected
+  std::map<unsigned, librevenge::RVNGBinaryData> m_vects;
+  // the bitmaps of the two-color patterns, by pattern and RGB foreground
+  // and background, shared by the fills using them
+  std::map<std::tuple<unsigned, unsigned, unsigned>, librevenge::RVNGBinaryData> m_patternBitmaps;
+
   CDRParserState &m_ps;
 };
 
@@ -7,12 +7,19 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include <algorithm>
+#include <functional>
 #include <memory>
 #include <string>
+#include <thread>
 
 #include <libcdr/libcdr.h>
 #include "CDRParser.h"
+#include "CDRInflatePipeline.h"
+#include "CDRParseTracker.h"
+#include "CDRRecordTape.h"
 #include "CDRContentCollector.h"
+#include "CDRDrawingRecorder.h"
 #include "CDRStylesCollector.h"
 #include "libcdr_utils.h"
 #include "CDRDocumentStructure.h"
@@ -22,6 +29,9 @@ using namespace libcdr;
 namespace
 {
 
+/* The inflated cmpr lists waiting for the parser take at most about this */
+static const unsigned long INFLATE_QUEUE_SIZE = 64 * 1024 * 1024;
+
 static unsigned getCDRVersion(librevenge::RVNGInputStream *input)
 {
   unsigned riff = readU32(input);
@@ -51,55 +61,351 @@ static unsigned getCDRVersion(librevenge::RVNGInputStream *input)
   return 100 * (c - 0x37);
 }
 
-} // anonymous namespace
-
-/**
-Analyzes the content of an input stream to see if it can be parsed
-\param input The input stream
-\return A value that indicates whether the content from the input
-stream is a Corel Draw Document that libcdr is able to parse
-*/
-CDRAPI bool libcdr::CDRDocument::isSupported(librevenge::RVNGInputStream *input_) try
+/* Opens the stream holding the records of a zipped document, and the
+   streams holding the data of its records */
+static void openStructuredDocument(librevenge::RVNGInputStream *tmpInput, std::shared_ptr<librevenge::RVNGInputStream> &input,
+                                   std::vector<std::unique_ptr<librevenge::RVNGInputStream>> &dataStreams)
 {
-  if (!input_)
-    return false;
-
-  librevenge::RVNGInputStream *tmpInput = input_;
-  std::shared_ptr<librevenge::RVNGInputStream> input(input_, CDRDummyDeleter());
-
-  input->seek(0, librevenge::RVNG_SEEK_SET);
-  unsigned version = getCDRVersion(input.get());
-  if (version)
-    return true;
+  std::vector<std::string> dataFiles;
   if (tmpInput->isStructured())
   {
-    input.reset(tmpInput->getSubStreamByName("content/riffData.cdr"));
+    tmpInput->seek(0, librevenge::RVNG_SEEK_SET);
+    input.reset(tmpInput->getOnDemandSubStreamByName("content/riffData.cdr"));
     if (!input)
-      input.reset(tmpInput->getSubStreamByName("content/root.dat"));
+    {
+      tmpInput->seek(0, librevenge::RVNG_SEEK_SET);
+      input.reset(tmpInput->getOnDemandSubStreamByName("content/root.dat"));
+      if (input)
+      {
+        std::unique_ptr<librevenge::RVNGInputStream> tmpStream(tmpInput->getSubStreamByName("content/dataFileList.dat"));
+        if (bool(tmpStream))
+        {
+          std::string dataFileName;
+          while (!tmpStream->isEnd())
+          {
+            unsigned char character = readU8(tmpStream.get());
+            if (character == 0x0a)
+            {
+              dataFiles.push_back(dataFileName);
+              dataFileName.clear();
+            }
+            else
+              dataFileName += (char)character;
+          }
+          if (!dataFileName.empty())
+            dataFiles.push_back(dataFileName);
+        }
+      }
+    }
+  }
+  dataStreams.reserve(dataFiles.size());
+  for (const auto &dataFile : dataFiles)
+  {
+    std::string streamName("content/data/");
+    streamName += dataFile;
+    CDR_DEBUG_MSG(("Extracting stream: %s\n", streamName.c_str()));
+    tmpInput->seek(0, librevenge::RVNG_SEEK_SET);
+    std::unique_ptr<librevenge::RVNGInputStream> strm(tmpInput->getOnDemandSubStreamByName(streamName.c_str()));
+    dataStreams.push_back(std::move(strm));
   }
-  tmpInput->seek(0, librevenge::RVNG_SEEK_SET);
   if (!input)
-    return false;
+    input.reset(tmpInput, CDRDummyDeleter());
+}
+
+/* Records the structure of the document, indexing its pages, without
+   reading the records themselves */
+static bool buildPageIndex(librevenge::RVNGInputStream *input, const std::vector<std::unique_ptr<librevenge::RVNGInputStream>> &dataStreams,
+                           CDRRecordTape &tape, CDRInflatePipeline *inflatePipeline = nullptr, CDRParseTracker *tracker = nullptr)
+{
+  CDRParserState ps;
+  CDRStylesCollector collector(ps);
+  CDRParser parser(dataStreams, &collector);
+  parser.setRecordTape(&tape, true);
+  parser.setInflatePipeline(inflatePipeline);
+  parser.setParseTracker(tracker);
   input->seek(0, librevenge::RVNG_SEEK_SET);
-  version = getCDRVersion(input.get());
-  if (!version)
+  return parser.parseRecords(input);
+}
+
+/* Turns the numbers of the drawn pages, as parsePages counts them, into
+   numbers of the page lists of tape. Returns false if there is no drawn
+   page firstPage */
+static bool findPageLists(const CDRRecordTape &tape, unsigned &firstPage, unsigned &lastPage)
+{
+  const std::vector<CDRRecordTape::Page> &pages = tape.getPages();
+  unsigned firstList = (unsigned)-1;
+  unsigned lastList = (unsigned)-1;
+  unsigned drawnPage = 0;
+  for (unsigned i = 0; i < pages.size() && lastList == (unsigned)-1; ++i)
+  {
+    if (!pages[i].isDrawn)
+      continue;
+    if (drawnPage == firstPage)
+      firstList = i;
+    if (drawnPage == lastPage)
+      lastList = i;
+    ++drawnPage;
+  }
+  if (firstList == (unsigned)-1)
     return false;
+  firstPage = firstList;
+  lastPage = lastList;
   return true;
 }
-catch (...)
+
+/* Tells whether the pages can be collected separately with the same
+   result as together: nothing may be drawn outside of the page lists,
+   and no page may define a vector pattern, which the following pages
+   could use */
+static bool arePagesIndependent(const CDRRecordTape &tape)
+{
+  const std::vector<CDRRecordTape::Entry> &entries = tape.getEntries();
+  const std::vector<CDRRecordTape::Page> &pages = tape.getPages();
+  size_t page = 0;
+  unsigned vectLevel = 0;
+  for (size_t i = 0; i < entries.size(); ++i)
+  {
+    if (page < pages.size() && pages[page].begin == i)
+    {
+      for (; i < pages[page].end; ++i)
+      {
+        if (entries[i].fourCC == CDR_FOURCC_spnd || entries[i].fourCC == CDR_FOURCC_vpat)
+          return false;
+      }
+      --i;
+      ++page;
+      continue;
+    }
+    const CDRRecordTape::Entry &entry = entries[i];
+    if (vectLevel && entry.level <= vectLevel)
+      vectLevel = 0;
+    if (vectLevel)
+      continue;
+    if (entry.fourCC == CDR_FOURCC_RIFF || entry.fourCC == CDR_FOURCC_LIST)
+    {
+      if (entry.listType == CDR_FOURCC_vect || entry.listType == CDR_FOURCC_clpt)
+        vectLevel = entry.level;
+      else if (entry.listType == CDR_FOURCC_obj || entry.listType == CDR_FOURCC_grp || entry.listType == CDR_FOURCC_lnkg)
+        return false;
+    }
+    else if (entry.fourCC == CDR_FOURCC_flgs)
+      return false;
+  }
+  return true;
+}
+
+static bool readsInput(const CDRRecordTape &tape)
 {
+  for (const auto &entry : tape.getEntries())
+  {
+    if (entry.fourCC && entry.fourCC != CDR_FOURCC_RIFF && entry.fourCC != CDR_FOURCC_LIST && entry.stream == CDRRecordTape::INPUT_STREAM)
+      return true;
+  }
   return false;
 }
 
-/**
-Parses the input stream content. It will make callbacks to the functions provided by a
-CDRPaintInterface class implementation when needed. This is often commonly called the
-'main parsing routine'.
-\param input The input stream
-\param painter A CDRPainterInterface implementation
-\return A value that indicates whether the parsing was successful
-*/
-CDRAPI bool libcdr::CDRDocument::parse(librevenge::RVNGInputStream *input_, librevenge::RVNGDrawingInterface *painter)
+struct PageWorker
+{
+  PageWorker()
+    : firstPage(0), lastPage(0), input(), dataStreams(), recorder(), result(false) {}
+  unsigned firstPage;
+  unsigned lastPage;
+  std::unique_ptr<librevenge::RVNGInputStream> input;
+  std::vector<std::unique_ptr<librevenge::RVNGInputStream>> dataStreams;
+  CDRDrawingRecorder recorder;
+  bool result;
+};
+
+static void collectPages(PageWorker &worker, librevenge::RVNGInputStream *input, const CDRRecordTape &tape,
+                         CDRParserState &ps, unsigned pageIndex)
+{
+  try
+  {
+    CDRContentCollector contentCollector(ps, &worker.recorder);
+    contentCollector.setPageIndex(pageIndex);
+    CDRParser contentParser(worker.dataStreams, &contentCollector);
+    contentParser.setParseOptions(ps.m_options);
+    contentParser.setSkipStylesRecords(true);
+    contentParser.setParseTracker(ps.m_tracker);
+    worker.result = contentParser.replayRecords(worker.input ? worker.input.get() : input, tape, worker.firstPage, worker.lastPage);
+  }
+  catch (...)
+  {
+    worker.result = false;
+  }
+}
+
+/* Collects the pages firstPage to lastPage of tape in several threads,
+   each one recording the drawing of a range of pages, and sends the
+   records to painter in the page order. Both the styles passes collect
+   the pages firstPage to lastPage only, so the page firstPage is the
+   first page of ps.
+   Returns false, without drawing anything, if the pages can not be
+   collected in parallel */
+static bool collectPagesInParallel(librevenge::RVNGInputStream *input, const std::vector<std::unique_ptr<librevenge::RVNGInputStream>> &dataStreams,
+                                   CDRParserState &ps, librevenge::RVNGDrawingInterface *painter, const CDRRecordTape &tape,
+                                   unsigned firstPage, unsigned lastPage, unsigned threadCount, bool &retVal)
+{
+  const std::vector<CDRRecordTape::Page> &pages = tape.getPages();
+  if (firstPage >= pages.size())
+    return false;
+  lastPage = std::min(lastPage, unsigned(pages.size() - 1));
+  if (!threadCount)
+    threadCount = std::thread::hardware_concurrency();
+  const unsigned workerCount = std::min(threadCount, lastPage - firstPage + 1);
+  if (workerCount < 2 || !arePagesIndependent(tape))
+    return false;
+
+  // every worker gets about the same number of records
+  size_t remaining = 0;
+  for (unsigned page = firstPage; page <= lastPage; ++page)
+    remaining += pages[page].end - pages[page].begin;
+  const bool needsInput = readsInput(tape);
+  std::vector<std::unique_ptr<PageWorker>> workers;
+  unsigned page = firstPage;
+  for (unsigned left = workerCount; left && page <= lastPage; --left)
+  {
+    std::unique_ptr<PageWorker> worker(new PageWorker());
+    const size_t target = (remaining + left - 1) / left;
+    size_t size = 0;
+    worker->firstPage = page;
+    do
+    {
+      size += pages[page].end - pages[page].begin;
+      ++page;
+    }
+    while (page <= lastPage && size < target && lastPage - page + 1 >= left);
+    worker->lastPage = page - 1;
+    remaining -= size;
+
+    // every thread reads its own streams
+    if (needsInput)
+    {
+      worker->input.reset(input->clone());
+      if (!worker->input)
+        return false;
+    }
+    for (const auto &dataStream : dataStreams)
+    {
+      worker->dataStreams.push_back(std::unique_ptr<librevenge::RVNGInputStream>(dataStream ? dataStream->clone() : nullptr));
+      if (dataStream && !worker->dataStreams.back())
+        return false;
+    }
+    workers.push_back(std::move(worker));
+  }
+
+  std::vector<std::thread> threads;
+  try
+  {
+    for (auto &worker : workers)
+      threads.push_back(std::thread(collectPages, std::ref(*worker), input, std::cref(tape), std::ref(ps),
+                                    worker->firstPage - firstPage));
+  }
+  catch (...)
+  {
+    for (auto &thread : threads)
+      thread.join();
+    return false;
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  // a failing range ends the drawing, as it would end a single pass
+  bool isDocumentStarted = false;
+  retVal = true;
+  for (const auto &worker : workers)
+  {
+    worker->recorder.replay(painter, !isDocumentStarted, false);
+    isDocumentStarted = isDocumentStarted || worker->recorder.isDocumentStarted();
+    if (!worker->result)
+    {
+      retVal = false;
+      break;
+    }
+  }
+  if (isDocumentStarted)
+    painter->endDocument();
+  return true;
+}
+
+static bool parseRecords(librevenge::RVNGInputStream *input, const std::vector<std::unique_ptr<librevenge::RVNGInputStream>> &dataStreams,
+                         CDRParserState &ps, librevenge::RVNGDrawingInterface *painter, unsigned firstPage, unsigned lastPage)
+{
+  bool retVal = false;
+  const unsigned threadCount = ps.m_options.threadCount;
+  CDRRecordTape tape;
+  CDRStylesCollector stylesCollector(ps);
+  CDRParser stylesParser(dataStreams, &stylesCollector);
+  stylesParser.setParseOptions(ps.m_options);
+  stylesParser.setParseTracker(ps.m_tracker);
+  if (ps.m_tracker)
+    ps.m_tracker->setTotalBytes(getLength(input));
+  const bool allPages = !firstPage && lastPage == (unsigned)-1;
+  if (allPages && threadCount == 1 && !ps.m_options.cacheRecords)
+  {
+    // two plain passes over the input: slower, as the cmpr lists are
+    // inflated twice, but only the list being read is held in memory
+    input->seek(0, librevenge::RVNG_SEEK_SET);
+    retVal = stylesParser.parseRecords(input);
+    if (ps.m_pages.empty())
+      retVal = false;
+    if (retVal)
+    {
+      input->seek(0, librevenge::RVNG_SEEK_SET);
+      CDRContentCollector contentCollector(ps, painter);
+      CDRParser contentParser(dataStreams, &contentCollector);
+      contentParser.setParseOptions(ps.m_options);
+      contentParser.setSkipStylesRecords(true);
+      contentParser.setParseTracker(ps.m_tracker);
+      retVal = contentParser.parseRecords(input);
+    }
+    return retVal;
+  }
+  {
+    // the cmpr lists are only read by the first pass, which then uses
+    // other threads to inflate them while it parses the previous ones
+    std::unique_ptr<CDRInflatePipeline> inflatePipeline;
+    if (threadCount != 1)
+      inflatePipeline.reset(new CDRInflatePipeline(input, threadCount, INFLATE_QUEUE_SIZE,
+                                                   ps.m_tracker ? ps.m_tracker->getInflateBudget() : (unsigned long)-1));
+    if (allPages)
+    {
+      // the whole document is needed, so the structure is recorded while reading the styles
+      stylesParser.setRecordTape(&tape);
+      stylesParser.setInflatePipeline(inflatePipeline.get());
+      input->seek(0, librevenge::RVNG_SEEK_SET);
+      retVal = stylesParser.parseRecords(input);
+    }
+    else
+      retVal = buildPageIndex(input, dataStreams, tape, inflatePipeline.get(), ps.m_tracker);
+  }
+  if (!allPages)
+  {
+    // both passes skip the same pages, so the page sizes collected by the
+    // first one match the pages met by the second one
+    retVal = retVal && findPageLists(tape, firstPage, lastPage);
+    if (retVal)
+      retVal = stylesParser.replayRecords(input, tape, firstPage, lastPage);
+  }
+  if (ps.m_pages.empty())
+    retVal = false;
+  if (retVal)
+  {
+    input->seek(0, librevenge::RVNG_SEEK_SET);
+    if (threadCount != 1 && collectPagesInParallel(input, dataStreams, ps, painter, tape, firstPage, lastPage, threadCount, retVal))
+      return retVal;
+    CDRContentCollector contentCollector(ps, painter);
+    CDRParser contentParser(dataStreams, &contentCollector);
+    contentParser.setParseOptions(ps.m_options);
+    contentParser.setSkipStylesRecords(true);
+    contentParser.setParseTracker(ps.m_tracker);
+    retVal = contentParser.replayRecords(input, tape, firstPage, lastPage);
+  }
+  return retVal;
+}
+
+static bool parseInput(librevenge::RVNGInputStream *input_, librevenge::RVNGDrawingInterface *painter, unsigned firstPage, unsigned lastPage,
+                       const CDRParseOptions &options, CDRParseTracker *tracker)
 {
   if (!input_ || !painter)
     return false;
@@ -112,17 +418,27 @@ CDRAPI bool libcdr::CDRDocument::parse(librevenge::RVNGInputStream *input_, libr
   try
   {
     version = getCDRVersion(input.get());
-    if (version)
+    if (version >= 300)
     {
+      std::vector<std::unique_ptr<librevenge::RVNGInputStream>> dummyDataStreams;
+      CDRParserState ps(options, tracker);
+      return parseRecords(input.get(), dummyDataStreams, ps, painter, firstPage, lastPage);
+    }
+    else if (version)
+    {
+      // there is no page index for these files
+      if (firstPage || lastPage != (unsigned)-1)
+        return false;
       input->seek(0, librevenge::RVNG_SEEK_SET);
-      CDRParserState ps;
+      CDRParserState ps(options, tracker);
       std::vector<std::unique_ptr<librevenge::RVNGInputStream>> dummyDataStreams;
       CDRStylesCollector stylesCollector(ps);
       CDRParser stylesParser(dummyDataStreams, &stylesCollector);
-      if (version >= 300)
-        retVal = stylesParser.parseRecords(input.get());
-      else
-        retVal = stylesParser.parseWaldo(input.get());
+      stylesParser.setParseOptions(options);
+      stylesParser.setParseTracker(tracker);
+      if (tracker)
+        tracker->setTotalBytes(getLength(input.get()));
+      retVal = stylesParser.parseWaldo(input.get());
       if (ps.m_pages.empty())
         retVal = false;
       if (retVal)
@@ -130,10 +446,9 @@ CDRAPI bool libcdr::CDRDocument::parse(librevenge::RVNGInputStream *input_, libr
         input->seek(0, librevenge::RVNG_SEEK_SET);
         CDRContentCollector contentCollector(ps, painter);
         CDRParser contentParser(dummyDataStreams, &contentCollector);
-        if (version >= 300)
-          retVal = contentParser.parseRecords(input.get());
-        else
-          retVal = contentParser.parseWaldo(input.get());
+        contentParser.setParseOptions(options);
+        contentParser.setParseTracker(tracker);
+        retVal = contentParser.parseWaldo(input.get());
       }
       return retVal;
     }
@@ -147,52 +462,9 @@ CDRAPI bool libcdr::CDRDocument::parse(librevenge::RVNGInputStream *input_, libr
   librevenge::RVNGInputStream *tmpInput = input_;
   try
   {
-    std::vector<std::string> dataFiles;
-    if (tmpInput->isStructured())
-    {
-      tmpInput->seek(0, librevenge::RVNG_SEEK_SET);
-      input.reset(tmpInput->getSubStreamByName("content/riffData.cdr"));
-      if (!input)
-      {
-        tmpInput->seek(0, librevenge::RVNG_SEEK_SET);
-        input.reset(tmpInput->getSubStreamByName("content/root.dat"));
-        if (input)
-        {
-          std::unique_ptr<librevenge::RVNGInputStream> tmpStream(tmpInput->getSubStreamByName("content/dataFileList.dat"));
-          if (bool(tmpStream))
-          {
-            std::string dataFileName;
-            while (!tmpStream->isEnd())
-            {
-              unsigned char character = readU8(tmpStream.get());
-              if (character == 0x0a)
-              {
-                dataFiles.push_back(dataFileName);
-                dataFileName.clear();
-              }
-              else
-                dataFileName += (char)character;
-            }
-            if (!dataFileName.empty())
-              dataFiles.push_back(dataFileName);
-          }
-        }
-      }
-    }
     std::vector<std::unique_ptr<librevenge::RVNGInputStream>> dataStreams;
-    dataStreams.reserve(dataFiles.size());
-    for (const auto &dataFile : dataFiles)
-    {
-      std::string streamName("content/data/");
-      streamName += dataFile;
-      CDR_DEBUG_MSG(("Extracting stream: %s\n", streamName.c_str()));
-      tmpInput->seek(0, librevenge::RVNG_SEEK_SET);
-      std::unique_ptr<librevenge::RVNGInputStream> strm(tmpInput->getSubStreamByName(streamName.c_str()));
-      dataStreams.push_back(std::move(strm));
-    }
-    if (!input)
-      input.reset(tmpInput, CDRDummyDeleter());
-    CDRParserState ps;
+    openStructuredDocument(tmpInput, input, dataStreams);
+    CDRParserState ps(options, tracker);
     {
       // libcdr extension to the getSubStreamByName. Will extract the first stream in the
       // given directory
@@ -207,19 +479,7 @@ CDRAPI bool libcdr::CDRDocument::parse(librevenge::RVNGInputStream *input_, libr
       if (rgbProfile)
         ps.setColorTransform(rgbProfile.get());
     }
-    CDRStylesCollector stylesCollector(ps);
-    CDRParser stylesParser(dataStreams, &stylesCollector);
-    input->seek(0, librevenge::RVNG_SEEK_SET);
-    retVal = stylesParser.parseRecords(input.get());
-    if (ps.m_pages.empty())
-      retVal = false;
-    if (retVal)
-    {
-      input->seek(0, librevenge::RVNG_SEEK_SET);
-      CDRContentCollector contentCollector(ps, painter);
-      CDRParser contentParser(dataStreams, &contentCollector);
-      retVal = contentParser.parseRecords(input.get());
-    }
+    retVal = parseRecords(input.get(), dataStreams, ps, painter, firstPage, lastPage);
   }
   catch (libcdr::EndOfStreamException const &)
   {
@@ -228,4 +488,170 @@ CDRAPI bool libcdr::CDRDocument::parse(librevenge::RVNGInputStream *input_, libr
   return retVal;
 }
 
+static bool parseDocument(librevenge::RVNGInputStream *input, librevenge::RVNGDrawingInterface *painter, unsigned firstPage, unsigned lastPage,
+                          const CDRParseOptions &options)
+{
+  std::unique_ptr<CDRParseTracker> tracker(options.control ? new CDRParseTracker(*options.control) : nullptr);
+  const bool retVal = parseInput(input, painter, firstPage, lastPage, options, tracker.get());
+  return tracker ? tracker->finish(retVal) : retVal;
+}
+
+} // anonymous namespace
+
+/**
+Analyzes the content of an input stream to see if it can be parsed
+\param input The input stream
+\return A value that indicates whether the content from the input
+stream is a Corel Draw Document that libcdr is able to parse
+*/
+CDRAPI bool libcdr::CDRDocument::isSupported(librevenge::RVNGInputStream *input_) try
+{
+  if (!input_)
+    return false;
+
+  librevenge::RVNGInputStream *tmpInput = input_;
+  std::shared_ptr<librevenge::RVNGInputStream> input(input_, CDRDummyDeleter());
+
+  input->seek(0, librevenge::RVNG_SEEK_SET);
+  unsigned version = getCDRVersion(input.get());
+  if (version)
+    return true;
+  if (tmpInput->isStructured())
+  {
+    input.reset(tmpInput->getOnDemandSubStreamByName("content/riffData.cdr"));
+    if (!input)
+      input.reset(tmpInput->getOnDemandSubStreamByName("content/root.dat"));
+  }
+  tmpInput->seek(0, librevenge::RVNG_SEEK_SET);
+  if (!input)
+    return false;
+  input->seek(0, librevenge::RVNG_SEEK_SET);
+  version = getCDRVersion(input.get());
+  if (!version)
+    return false;
+  return true;
+}
+catch (...)
+{
+  return false;
+}
+
+/**
+Parses the input stream content. It will make callbacks to the functions provided by a
+CDRPaintInterface class implementation when needed. This is often commonly called the
+'main parsing routine'.
+\param input The input stream
+\param painter A CDRPainterInterface implementation
+\return A value that indicates whether the parsing was successful
+*/
+CDRAPI bool libcdr::CDRDocument::parse(librevenge::RVNGInputStream *input, librevenge::RVNGDrawingInterface *painter)
+{
+  return parseDocument(input, painter, 0, (unsigned)-1, CDRParseOptions());
+}
+
+/**
+Parses the input stream content, collecting the pages in several threads. The drawing
+calls of every thread are recorded, then made to the painter in the page order, so that
+they are the same as with a single thread. Documents whose pages depend on each other
+are parsed in a single thread.
+\param input The input stream
+\param painter A CDRPainterInterface implementation
+\param threadCount The maximal number of threads, or 0 to use as many threads as
+the hardware runs at once
+\return A value that indicates whether the parsing was successful
+*/
+CDRAPI bool libcdr::CDRDocument::parse(librevenge::RVNGInputStream *input, librevenge::RVNGDrawingInterface *painter, unsigned threadCount)
+{
+  CDRParseOptions options;
+  options.threadCount = threadCount;
+  return parseDocument(input, painter, 0, (unsigned)-1, options);
+}
+
+/**
+Parses the input stream content with the features turned on by options. The threads
+are used as for the parse taking a number of threads.
+\param input The input stream
+\param painter A CDRPainterInterface implementation
+\param options The features of the parse and its number of threads
+\return A value that indicates whether the parsing was successful
+*/
+CDRAPI bool libcdr::CDRDocument::parse(librevenge::RVNGInputStream *input, librevenge::RVNGDrawingInterface *painter, const CDRParseOptions &options)
+{
+  return parseDocument(input, painter, 0, (unsigned)-1, options);
+}
+
+/**
+Parses some pages of the input stream content, skipping the others. The pages are
+the drawn pages of the document, counted from 0, so the pages which are not drawn,
+like the master page, are left out of the numbering.
+\param input The input stream
+\param painter A CDRPainterInterface implementation
+\param firstPage The first page to parse
+\param lastPage The last page to parse
+\param threadCount The maximal number of threads collecting the pages, as for parse
+\return A value that indicates whether the parsing was successful. It is false
+for the documents older than version 3, which have no page index.
+*/
+CDRAPI bool libcdr::CDRDocument::parsePages(librevenge::RVNGInputStream *input, librevenge::RVNGDrawingInterface *painter,
+                                            unsigned firstPage, unsigned lastPage, unsigned threadCount)
+{
+  CDRParseOptions options;
+  options.threadCount = threadCount;
+  return parsePages(input, painter, firstPage, lastPage, options);
+}
+
+/**
+Parses some pages of the input stream content, as the parsePages taking a number of
+threads, with the features turned on by options.
+\param input The input stream
+\param painter A CDRPainterInterface implementation
+\param firstPage The first page to parse
+\param lastPage The last page to parse
+\param options The features of the parse and its number of threads
+\return A value that indicates whether the parsing was successful
+*/
+CDRAPI bool libcdr::CDRDocument::parsePages(librevenge::RVNGInputStream *input, librevenge::RVNGDrawingInterface *painter,
+                                            unsigned firstPage, unsigned lastPage, const CDRParseOptions &options)
+{
+  if (firstPage > lastPage)
+    return false;
+  return parseDocument(input, painter, firstPage, lastPage, options);
+}
+
+/**
+Counts the pages of the input stream content, as numbered by parsePages. Only the
+structure of the document is read, so it is much faster than parsing it.
+\param input The input stream
+\return The number of pages, or 0 if the document can not be parsed or is older
+than version 3
+*/
+CDRAPI unsigned libcdr::CDRDocument::getPageCount(librevenge::RVNGInputStream *input_) try
+{
+  if (!input_)
+    return 0;
+
+  std::shared_ptr<librevenge::RVNGInputStream> input(input_, CDRDummyDeleter());
+  std::vector<std::unique_ptr<librevenge::RVNGInputStream>> dataStreams;
+  input->seek(0, librevenge::RVNG_SEEK_SET);
+  unsigned version = getCDRVersion(input.get());
+  if (version && version < 300)
+    return 0;
+  if (!version)
+    openStructuredDocument(input_, input, dataStreams);
+  CDRRecordTape tape;
+  if (!buildPageIndex(input.get(), dataStreams, tape))
+    return 0;
+  unsigned pageCount = 0;
+  for (const auto &page : tape.getPages())
+  {
+    if (page.isDrawn)
+      ++pageCount;
+  }
+  return pageCount;
+}
+catch (...)
+{
+  return 0;
+}
+
 /* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,451 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libcdr project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "CDRDrawingRecorder.h"
+
+libcdr::CDRDrawingRecorder::CDRDrawingRecorder()
+  : m_calls(), m_propLists(), m_strings(), m_isDocumentStarted(false)
+{
+}
+
+libcdr::CDRDrawingRecorder::~CDRDrawingRecorder()
+{
+}
+
+void libcdr::CDRDrawingRecorder::record(CallType type)
+{
+  Call call = { type, 0 };
+  m_calls.push_back(call);
+}
+
+void libcdr::CDRDrawingRecorder::record(CallType type, const librevenge::RVNGPropertyList &propList)
+{
+  Call call = { type, m_propLists.size() };
+  m_propLists.push_back(propList);
+  m_calls.push_back(call);
+}
+
+void libcdr::CDRDrawingRecorder::replay(librevenge::RVNGDrawingInterface *painter, bool withStartDocument, bool withEndDocument) const
+{
+  if (!painter)
+    return;
+  for (const auto &call : m_calls)
+  {
+    switch (call.type)
+    {
+    case CALL_STARTDOCUMENT:
+      if (withStartDocument)
+        painter->startDocument(m_propLists[call.index]);
+      break;
+    case CALL_ENDDOCUMENT:
+      if (withEndDocument)
+        painter->endDocument();
+      break;
+    case CALL_SETDOCUMENTMETADATA:
+      painter->setDocumentMetaData(m_propLists[call.index]);
+      break;
+    case CALL_DEFINEEMBEDDEDFONT:
+      painter->defineEmbeddedFont(m_propLists[call.index]);
+      break;
+    case CALL_STARTPAGE:
+      painter->startPage(m_propLists[call.index]);
+      break;
+    case CALL_ENDPAGE:
+      painter->endPage();
+      break;
+    case CALL_STARTMASTERPAGE:
+      painter->startMasterPage(m_propLists[call.index]);
+      break;
+    case CALL_ENDMASTERPAGE:
+      painter->endMasterPage();
+      break;
+    case CALL_SETSTYLE:
+      painter->setStyle(m_propLists[call.index]);
+      break;
+    case CALL_STARTLAYER:
+      painter->startLayer(m_propLists[call.index]);
+      break;
+    case CALL_ENDLAYER:
+      painter->endLayer();
+      break;
+    case CALL_STARTEMBEDDEDGRAPHICS:
+      painter->startEmbeddedGraphics(m_propLists[call.index]);
+      break;
+    case CALL_ENDEMBEDDEDGRAPHICS:
+      painter->endEmbeddedGraphics();
+      break;
+    case CALL_OPENGROUP:
+      painter->openGroup(m_propLists[call.index]);
+      break;
+    case CALL_CLOSEGROUP:
+      painter->closeGroup();
+      break;
+    case CALL_DRAWRECTANGLE:
+      painter->drawRectangle(m_propLists[call.index]);
+      break;
+    case CALL_DRAWELLIPSE:
+      painter->drawEllipse(m_propLists[call.index]);
+      break;
+    case CALL_DRAWPOLYGON:
+      painter->drawPolygon(m_propLists[call.index]);
+      break;
+    case CALL_DRAWPOLYLINE:
+      painter->drawPolyline(m_propLists[call.index]);
+      break;
+    case CALL_DRAWPATH:
+      painter->drawPath(m_propLists[call.index]);
+      break;
+    case CALL_DRAWGRAPHICOBJECT:
+      painter->drawGraphicObject(m_propLists[call.index]);
+      break;
+    case CALL_DRAWCONNECTOR:
+      painter->drawConnector(m_propLists[call.index]);
+      break;
+    case CALL_STARTTEXTOBJECT:
+      painter->startTextObject(m_propLists[call.index]);
+      break;
+    case CALL_ENDTEXTOBJECT:
+      painter->endTextObject();
+      break;
+    case CALL_STARTTABLEOBJECT:
+      painter->startTableObject(m_propLists[call.index]);
+      break;
+    case CALL_OPENTABLEROW:
+      painter->openTableRow(m_propLists[call.index]);
+      break;
+    case CALL_CLOSETABLEROW:
+      painter->closeTableRow();
+      break;
+    case CALL_OPENTABLECELL:
+      painter->openTableCell(m_propLists[call.index]);
+      break;
+    case CALL_CLOSETABLECELL:
+      painter->closeTableCell();
+      break;
+    case CALL_INSERTCOVEREDTABLECELL:
+      painter->insertCoveredTableCell(m_propLists[call.index]);
+      break;
+    case CALL_ENDTABLEOBJECT:
+      painter->endTableObject();
+      break;
+    case CALL_INSERTTAB:
+      painter->insertTab();
+      break;
+    case CALL_INSERTSPACE:
+      painter->insertSpace();
+      break;
+    case CALL_INSERTTEXT:
+      painter->insertText(m_strings[call.index]);
+      break;
+    case CALL_INSERTLINEBREAK:
+      painter->insertLineBreak();
+      break;
+    case CALL_INSERTFIELD:
+      painter->insertField(m_propLists[call.index]);
+      break;
+    case CALL_OPENORDEREDLISTLEVEL:
+      painter->openOrderedListLevel(m_propLists[call.index]);
+      break;
+    case CALL_OPENUNORDEREDLISTLEVEL:
+      painter->openUnorderedListLevel(m_propLists[call.index]);
+      break;
+    case CALL_CLOSEORDEREDLISTLEVEL:
+      painter->closeOrderedListLevel();
+      break;
+    case CALL_CLOSEUNORDEREDLISTLEVEL:
+      painter->closeUnorderedListLevel();
+      break;
+    case CALL_OPENLISTELEMENT:
+      painter->openListElement(m_propLists[call.index]);
+      break;
+    case CALL_CLOSELISTELEMENT:
+      painter->closeListElement();
+      break;
+    case CALL_DEFINEPARAGRAPHSTYLE:
+      painter->defineParagraphStyle(m_propLists[call.index]);
+      break;
+    case CALL_OPENPARAGRAPH:
+      painter->openParagraph(m_propLists[call.index]);
+      break;
+    case CALL_CLOSEPARAGRAPH:
+      painter->closeParagraph();
+      break;
+    case CALL_DEFINECHARACTERSTYLE:
+      painter->defineCharacterStyle(m_propLists[call.index]);
+      break;
+    case CALL_OPENSPAN:
+      painter->openSpan(m_propLists[call.index]);
+      break;
+    case CALL_CLOSESPAN:
+      painter->closeSpan();
+      break;
+    case CALL_OPENLINK:
+      painter->openLink(m_propLists[call.index]);
+      break;
+    case CALL_CLOSELINK:
+      painter->closeLink();
+      break;
+    }
+  }
+}
+
+void libcdr::CDRDrawingRecorder::startDocument(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_STARTDOCUMENT, propList);
+  m_isDocumentStarted = true;
+}
+
+void libcdr::CDRDrawingRecorder::endDocument()
+{
+  record(CALL_ENDDOCUMENT);
+}
+
+void libcdr::CDRDrawingRecorder::setDocumentMetaData(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_SETDOCUMENTMETADATA, propList);
+}
+
+void libcdr::CDRDrawingRecorder::defineEmbeddedFont(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_DEFINEEMBEDDEDFONT, propList);
+}
+
+void libcdr::CDRDrawingRecorder::startPage(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_STARTPAGE, propList);
+}
+
+void libcdr::CDRDrawingRecorder::endPage()
+{
+  record(CALL_ENDPAGE);
+}
+
+void libcdr::CDRDrawingRecorder::startMasterPage(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_STARTMASTERPAGE, propList);
+}
+
+void libcdr::CDRDrawingRecorder::endMasterPage()
+{
+  record(CALL_ENDMASTERPAGE);
+}
+
+void libcdr::CDRDrawingRecorder::setStyle(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_SETSTYLE, propList);
+}
+
+void libcdr::CDRDrawingRecorder::startLayer(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_STARTLAYER, propList);
+}
+
+void libcdr::CDRDrawingRecorder::endLayer()
+{
+  record(CALL_ENDLAYER);
+}
+
+void libcdr::CDRDrawingRecorder::startEmbeddedGraphics(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_STARTEMBEDDEDGRAPHICS, propList);
+}
+
+void libcdr::CDRDrawingRecorder::endEmbeddedGraphics()
+{
+  record(CALL_ENDEMBEDDEDGRAPHICS);
+}
+
+void libcdr::CDRDrawingRecorder::openGroup(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_OPENGROUP, propList);
+}
+
+void libcdr::CDRDrawingRecorder::closeGroup()
+{
+  record(CALL_CLOSEGROUP);
+}
+
+void libcdr::CDRDrawingRecorder::drawRectangle(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_DRAWRECTANGLE, propList);
+}
+
+void libcdr::CDRDrawingRecorder::drawEllipse(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_DRAWELLIPSE, propList);
+}
+
+void libcdr::CDRDrawingRecorder::drawPolygon(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_DRAWPOLYGON, propList);
+}
+
+void libcdr::CDRDrawingRecorder::drawPolyline(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_DRAWPOLYLINE, propList);
+}
+
+void libcdr::CDRDrawingRecorder::drawPath(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_DRAWPATH, propList);
+}
+
+void libcdr::CDRDrawingRecorder::drawGraphicObject(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_DRAWGRAPHICOBJECT, propList);
+}
+
+void libcdr::CDRDrawingRecorder::drawConnector(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_DRAWCONNECTOR, propList);
+}
+
+void libcdr::CDRDrawingRecorder::startTextObject(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_STARTTEXTOBJECT, propList);
+}
+
+void libcdr::CDRDrawingRecorder::endTextObject()
+{
+  record(CALL_ENDTEXTOBJECT);
+}
+
+void libcdr::CDRDrawingRecorder::startTableObject(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_STARTTABLEOBJECT, propList);
+}
+
+void libcdr::CDRDrawingRecorder::openTableRow(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_OPENTABLEROW, propList);
+}
+
+void libcdr::CDRDrawingRecorder::closeTableRow()
+{
+  record(CALL_CLOSETABLEROW);
+}
+
+void libcdr::CDRDrawingRecorder::openTableCell(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_OPENTABLECELL, propList);
+}
+
+void libcdr::CDRDrawingRecorder::closeTableCell()
+{
+  record(CALL_CLOSETABLECELL);
+}
+
+void libcdr::CDRDrawingRecorder::insertCoveredTableCell(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_INSERTCOVEREDTABLECELL, propList);
+}
+
+void libcdr::CDRDrawingRecorder::endTableObject()
+{
+  record(CALL_ENDTABLEOBJECT);
+}
+
+void libcdr::CDRDrawingRecorder::insertTab()
+{
+  record(CALL_INSERTTAB);
+}
+
+void libcdr::CDRDrawingRecorder::insertSpace()
+{
+  record(CALL_INSERTSPACE);
+}
+
+void libcdr::CDRDrawingRecorder::insertText(const librevenge::RVNGString &text)
+{
+  Call call = { CALL_INSERTTEXT, m_strings.size() };
+  m_strings.push_back(text);
+  m_calls.push_back(call);
+}
+
+void libcdr::CDRDrawingRecorder::insertLineBreak()
+{
+  record(CALL_INSERTLINEBREAK);
+}
+
+void libcdr::CDRDrawingRecorder::insertField(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_INSERTFIELD, propList);
+}
+
+void libcdr::CDRDrawingRecorder::openOrderedListLevel(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_OPENORDEREDLISTLEVEL, propList);
+}
+
+void libcdr::CDRDrawingRecorder::openUnorderedListLevel(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_OPENUNORDEREDLISTLEVEL, propList);
+}
+
+void libcdr::CDRDrawingRecorder::closeOrderedListLevel()
+{
+  record(CALL_CLOSEORDEREDLISTLEVEL);
+}
+
+void libcdr::CDRDrawingRecorder::closeUnorderedListLevel()
+{
+  record(CALL_CLOSEUNORDEREDLISTLEVEL);
+}
+
+void libcdr::CDRDrawingRecorder::openListElement(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_OPENLISTELEMENT, propList);
+}
+
+void libcdr::CDRDrawingRecorder::closeListElement()
+{
+  record(CALL_CLOSELISTELEMENT);
+}
+
+void libcdr::CDRDrawingRecorder::defineParagraphStyle(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_DEFINEPARAGRAPHSTYLE, propList);
+}
+
+void libcdr::CDRDrawingRecorder::openParagraph(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_OPENPARAGRAPH, propList);
+}
+
+void libcdr::CDRDrawingRecorder::closeParagraph()
+{
+  record(CALL_CLOSEPARAGRAPH);
+}
+
+void libcdr::CDRDrawingRecorder::defineCharacterStyle(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_DEFINECHARACTERSTYLE, propList);
+}
+
+void libcdr::CDRDrawingRecorder::openSpan(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_OPENSPAN, propList);
+}
+
+void libcdr::CDRDrawingRecorder::closeSpan()
+{
+  record(CALL_CLOSESPAN);
+}
+
+void libcdr::CDRDrawingRecorder::openLink(const librevenge::RVNGPropertyList &propList)
+{
+  record(CALL_OPENLINK, propList);
+}
+
+void libcdr::CDRDrawingRecorder::closeLink()
+{
+  record(CALL_CLOSELINK);
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,164 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libcdr project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef __CDRDRAWINGRECORDER_H__
+#define __CDRDRAWINGRECORDER_H__
+
+#include <vector>
+
+#include <librevenge/librevenge.h>
+
+namespace libcdr
+{
+
+/* A drawing interface keeping the calls it receives, so that they can
+   be sent to another drawing interface later */
+class CDRDrawingRecorder : public librevenge::RVNGDrawingInterface
+{
+public:
+  CDRDrawingRecorder();
+  ~CDRDrawingRecorder() override;
+
+  /* Sends the recorded calls to painter. The calls to startDocument and
+     endDocument are left out unless asked for, so that the records of
+     several parts of a document can be joined */
+  void replay(librevenge::RVNGDrawingInterface *painter, bool withStartDocument, bool withEndDocument) const;
+  bool isDocumentStarted() const
+  {
+    return m_isDocumentStarted;
+  }
+
+  void startDocument(const librevenge::RVNGPropertyList &propList) override;
+  void endDocument() override;
+  void setDocumentMetaData(const librevenge::RVNGPropertyList &propList) override;
+  void defineEmbeddedFont(const librevenge::RVNGPropertyList &propList) override;
+  void startPage(const librevenge::RVNGPropertyList &propList) override;
+  void endPage() override;
+  void startMasterPage(const librevenge::RVNGPropertyList &propList) override;
+  void endMasterPage() override;
+  void setStyle(const librevenge::RVNGPropertyList &propList) override;
+  void startLayer(const librevenge::RVNGPropertyList &propList) override;
+  void endLayer() override;
+  void startEmbeddedGraphics(const librevenge::RVNGPropertyList &propList) override;
+  void endEmbeddedGraphics() override;
+  void openGroup(const librevenge::RVNGPropertyList &propList) override;
+  void closeGroup() override;
+  void drawRectangle(const librevenge::RVNGPropertyList &propList) override;
+  void drawEllipse(const librevenge::RVNGPropertyList &propList) override;
+  void drawPolygon(const librevenge::RVNGPropertyList &propList) override;
+  void drawPolyline(const librevenge::RVNGPropertyList &propList) override;
+  void drawPath(const librevenge::RVNGPropertyList &propList) override;
+  void drawGraphicObject(const librevenge::RVNGPropertyList &propList) override;
+  void drawConnector(const librevenge::RVNGPropertyList &propList) override;
+  void startTextObject(const librevenge::RVNGPropertyList &propList) override;
+  void endTextObject() override;
+  void startTableObject(const librevenge::RVNGPropertyList &propList) override;
+  void openTableRow(const librevenge::RVNGPropertyList &propList) override;
+  void closeTableRow() override;
+  void openTableCell(const librevenge::RVNGPropertyList &propList) override;
+  void closeTableCell() override;
+  void insertCoveredTableCell(const librevenge::RVNGPropertyList &propList) override;
+  void endTableObject() override;
+  void insertTab() override;
+  void insertSpace() override;
+  void insertText(const librevenge::RVNGString &text) override;
+  void insertLineBreak() override;
+  void insertField(const librevenge::RVNGPropertyList &propList) override;
+  void openOrderedListLevel(const librevenge::RVNGPropertyList &propList) override;
+  void openUnorderedListLevel(const librevenge::RVNGPropertyList &propList) override;
+  void closeOrderedListLevel() override;
+  void closeUnorderedListLevel() override;
+  void openListElement(const librevenge::RVNGPropertyList &propList) override;
+  void closeListElement() override;
+  void defineParagraphStyle(const librevenge::RVNGPropertyList &propList) override;
+  void openParagraph(const librevenge::RVNGPropertyList &propList) override;
+  void closeParagraph() override;
+  void defineCharacterStyle(const librevenge::RVNGPropertyList &propList) override;
+  void openSpan(const librevenge::RVNGPropertyList &propList) override;
+  void closeSpan() override;
+  void openLink(const librevenge::RVNGPropertyList &propList) override;
+  void closeLink() override;
+
+private:
+  enum CallType
+  {
+    CALL_STARTDOCUMENT,
+    CALL_ENDDOCUMENT,
+    CALL_SETDOCUMENTMETADATA,
+    CALL_DEFINEEMBEDDEDFONT,
+    CALL_STARTPAGE,
+    CALL_ENDPAGE,
+    CALL_STARTMASTERPAGE,
+    CALL_ENDMASTERPAGE,
+    CALL_SETSTYLE,
+    CALL_STARTLAYER,
+    CALL_ENDLAYER,
+    CALL_STARTEMBEDDEDGRAPHICS,
+    CALL_ENDEMBEDDEDGRAPHICS,
+    CALL_OPENGROUP,
+    CALL_CLOSEGROUP,
+    CALL_DRAWRECTANGLE,
+    CALL_DRAWELLIPSE,
+    CALL_DRAWPOLYGON,
+    CALL_DRAWPOLYLINE,
+    CALL_DRAWPATH,
+    CALL_DRAWGRAPHICOBJECT,
+    CALL_DRAWCONNECTOR,
+    CALL_STARTTEXTOBJECT,
+    CALL_ENDTEXTOBJECT,
+    CALL_STARTTABLEOBJECT,
+    CALL_OPENTABLEROW,
+    CALL_CLOSETABLEROW,
+    CALL_OPENTABLECELL,
+    CALL_CLOSETABLECELL,
+    CALL_INSERTCOVEREDTABLECELL,
+    CALL_ENDTABLEOBJECT,
+    CALL_INSERTTAB,
+    CALL_INSERTSPACE,
+    CALL_INSERTTEXT,
+    CALL_INSERTLINEBREAK,
+    CALL_INSERTFIELD,
+    CALL_OPENORDEREDLISTLEVEL,
+    CALL_OPENUNORDEREDLISTLEVEL,
+    CALL_CLOSEORDEREDLISTLEVEL,
+    CALL_CLOSEUNORDEREDLISTLEVEL,
+    CALL_OPENLISTELEMENT,
+    CALL_CLOSELISTELEMENT,
+    CALL_DEFINEPARAGRAPHSTYLE,
+    CALL_OPENPARAGRAPH,
+    CALL_CLOSEPARAGRAPH,
+    CALL_DEFINECHARACTERSTYLE,
+    CALL_OPENSPAN,
+    CALL_CLOSESPAN,
+    CALL_OPENLINK,
+    CALL_CLOSELINK
+  };
+
+  struct Call
+  {
+    CallType type;
+    size_t index;
+  };
+
+  CDRDrawingRecorder(const CDRDrawingRecorder &);
+  CDRDrawingRecorder &operator=(const CDRDrawingRecorder &);
+
+  void record(CallType type);
+  void record(CallType type, const librevenge::RVNGPropertyList &propList);
+
+  std::vector<Call> m_calls;
+  std::vector<librevenge::RVNGPropertyList> m_propLists;
+  std::vector<librevenge::RVNGString> m_strings;
+  bool m_isDocumentStarted;
+};
+
+} // namespace libcdr
+
+#endif // __CDRDRAWINGRECORDER_H__
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
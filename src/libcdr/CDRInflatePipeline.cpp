@@ -0,0 +1,292 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libcdr project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "CDRInflatePipeline.h"
+
+#include <algorithm>
+
+#include "../librevenge/RVNGInflate.h"
+#include "CDRDocumentStructure.h"
+
+namespace
+{
+
+/* Deeper lists are not looked into; the parser is not expected to get there */
+static const unsigned MAX_LIST_DEPTH = 64;
+
+/* Size of the header of a cmpr list, from its list type to the compressed data */
+static const unsigned long CMPR_HEADER_SIZE = 28;
+
+static unsigned getU32(const unsigned char *data)
+{
+  return unsigned(data[0]) | (unsigned(data[1]) << 8) | (unsigned(data[2]) << 16) | (unsigned(data[3]) << 24);
+}
+
+static unsigned getU16(const unsigned char *data)
+{
+  return unsigned(data[0]) | (unsigned(data[1]) << 8);
+}
+
+} // anonymous namespace
+
+libcdr::CDRInflatePipeline::CDRInflatePipeline(librevenge::RVNGInputStream *input, unsigned threadCount, unsigned long maxQueuedBytes,
+                                               unsigned long maxListSize) :
+  m_input(input),
+  m_clone(),
+  m_cloneMutex(),
+  m_hasReadAt(false),
+  m_jobs(),
+  m_jobIndex(),
+  m_nextJob(0),
+  m_nextTaken(0),
+  m_queuedBytes(0),
+  m_maxQueuedBytes(maxQueuedBytes),
+  m_maxListSize(maxListSize),
+  m_isStopping(false),
+  m_mutex(),
+  m_condition(),
+  m_threads()
+{
+  if (!m_input)
+    return;
+  unsigned char byte = 0;
+  m_hasReadAt = m_input->readAt(0, 1, &byte) == 1;
+  if (!m_hasReadAt)
+  {
+    m_clone.reset(m_input->clone());
+    if (!m_clone)
+      return;
+  }
+
+  findLists(0, (unsigned long)-1, 0);
+  for (size_t i = 0; i < m_jobs.size(); ++i)
+    m_jobIndex[m_jobs[i].offset] = i;
+
+  if (!threadCount)
+    threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+  threadCount = unsigned(std::min(size_t(threadCount), m_jobs.size()));
+  try
+  {
+    for (unsigned i = 0; i < threadCount; ++i)
+      m_threads.push_back(std::thread(&CDRInflatePipeline::work, this));
+  }
+  catch (...)
+  {
+    // the threads started so far are enough
+  }
+}
+
+libcdr::CDRInflatePipeline::~CDRInflatePipeline()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_isStopping = true;
+  }
+  m_condition.notify_all();
+  for (auto &thread : m_threads)
+    thread.join();
+}
+
+bool libcdr::CDRInflatePipeline::take(unsigned long offset, std::shared_ptr<const unsigned char> &data, unsigned long &dataSize,
+                                      std::vector<unsigned> &blockLengths)
+{
+  if (m_threads.empty())
+    return false;
+  const auto it = m_jobIndex.find(offset);
+  if (it == m_jobIndex.end())
+    return false;
+  const size_t index = it->second;
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  if (index < m_nextTaken)
+    return false;
+  // the lists before were skipped by the parser
+  for (size_t i = m_nextTaken; i < index; ++i)
+  {
+    Job &skipped = m_jobs[i];
+    if (skipped.isDone)
+    {
+      m_queuedBytes -= skipped.dataSize + skipped.blockLengths.size() * sizeof(unsigned);
+      skipped.data.reset();
+      std::vector<unsigned>().swap(skipped.blockLengths);
+    }
+  }
+  m_nextTaken = index;
+  m_condition.notify_all();
+
+  Job &job = m_jobs[index];
+  m_condition.wait(lock, [&job]() { return job.isDone; });
+  m_queuedBytes -= job.dataSize + job.blockLengths.size() * sizeof(unsigned);
+  const bool isValid = job.isValid;
+  if (isValid)
+  {
+    data = std::move(job.data);
+    dataSize = job.dataSize;
+    blockLengths = std::move(job.blockLengths);
+  }
+  job.data.reset();
+  std::vector<unsigned>().swap(job.blockLengths);
+  m_nextTaken = index + 1;
+  m_condition.notify_all();
+  return isValid;
+}
+
+unsigned long libcdr::CDRInflatePipeline::readAt(unsigned long offset, unsigned long numBytes, unsigned char *buffer)
+{
+  if (m_hasReadAt)
+    return m_input->readAt(offset, numBytes, buffer);
+  std::lock_guard<std::mutex> lock(m_cloneMutex);
+  if (offset > (unsigned long)((~0UL) >> 1) || m_clone->seek(long(offset), librevenge::RVNG_SEEK_SET))
+    return 0;
+  return m_clone->readInto(buffer, numBytes);
+}
+
+/* Walks the records from begin to end the way CDRParser::parseRecord
+   does, looking into the uncompressed lists */
+void libcdr::CDRInflatePipeline::findLists(unsigned long begin, unsigned long end, unsigned depth)
+{
+  unsigned char header[CMPR_HEADER_SIZE];
+  unsigned long pos = begin;
+  while (pos < end)
+  {
+    if (readAt(pos, 1, header) != 1)
+      return;
+    // the parser skips the zeros between the records
+    if (!header[0])
+    {
+      ++pos;
+      continue;
+    }
+    if (end - pos < 8)
+      return;
+    const unsigned long headerSize = readAt(pos, 12, header);
+    if (headerSize < 8)
+      return;
+    const unsigned fourCC = getU32(header);
+    const unsigned long length = getU32(header + 4);
+    const unsigned long position = pos + 8;
+    pos = position + length;
+    if ((fourCC != CDR_FOURCC_RIFF && fourCC != CDR_FOURCC_LIST) || headerSize < 12 || length < 4)
+      continue;
+
+    const unsigned listType = getU32(header + 8);
+    if (listType == CDR_FOURCC_cmpr)
+    {
+      if (readAt(position, CMPR_HEADER_SIZE, header) != CMPR_HEADER_SIZE)
+        continue;
+      if (getU32(header + 20) != CDR_FOURCC_CPng || getU16(header + 24) != 1 || getU16(header + 26) != 4)
+        continue;
+      Job job;
+      job.offset = position;
+      job.compressedSize = getU32(header + 4);
+      job.uncompressedSize = getU32(header + 8);
+      job.uncompressedBlocksSize = getU32(header + 16);
+      if (length < CMPR_HEADER_SIZE + job.compressedSize)
+        continue;
+      job.blocksSize = length - CMPR_HEADER_SIZE - job.compressedSize;
+      m_jobs.push_back(job);
+    }
+    else if (listType != CDR_FOURCC_stlt && depth < MAX_LIST_DEPTH && pos <= end)
+    {
+      // the parser reads nothing from a list going past the end of the input
+      unsigned char last = 0;
+      if (readAt(pos - 1, 1, &last) == 1)
+        findLists(position + 4, pos, depth + 1);
+    }
+  }
+}
+
+/* Inflates a list the way the CDRInternalStream constructor does. The
+   job is left invalid where the parser would behave differently, which
+   makes it inflate the list itself */
+void libcdr::CDRInflatePipeline::inflate(Job &job, Buffers &buffers)
+{
+  const unsigned long dataOffset = job.offset + CMPR_HEADER_SIZE;
+  buffers.compressed.resize(job.compressedSize);
+  if (job.compressedSize)
+  {
+    if (readAt(dataOffset, job.compressedSize, buffers.compressed.data()) != job.compressedSize)
+      return;
+    std::vector<unsigned char> data;
+    const librevenge::RVNGInflate::Result result
+      = librevenge::RVNGInflate::inflateBuffer(buffers.compressed.data(), job.compressedSize, false, job.uncompressedSize, data, m_maxListSize);
+    if (result == librevenge::RVNGInflate::TooBig)
+      return;
+    if (result != librevenge::RVNGInflate::Failed && !data.empty())
+    {
+      job.dataSize = data.size();
+      auto owner = std::make_shared<const std::vector<unsigned char> >(std::move(data));
+      job.data = std::shared_ptr<const unsigned char>(owner, owner->data());
+    }
+  }
+
+  buffers.blocks.clear();
+  if (job.blocksSize)
+  {
+    buffers.compressed.resize(job.blocksSize);
+    if (readAt(dataOffset + job.compressedSize, job.blocksSize, buffers.compressed.data()) != job.blocksSize)
+      return;
+    const librevenge::RVNGInflate::Result result
+      = librevenge::RVNGInflate::inflateBuffer(buffers.compressed.data(), job.blocksSize, false, job.uncompressedBlocksSize, buffers.blocks, m_maxListSize);
+    if (result == librevenge::RVNGInflate::TooBig)
+      return;
+    if (result == librevenge::RVNGInflate::Failed)
+      buffers.blocks.clear();
+  }
+  // the parser fails on a truncated block length
+  if (buffers.blocks.size() % 4)
+    return;
+  job.blockLengths.resize(buffers.blocks.size() / 4);
+  for (size_t i = 0; i < job.blockLengths.size(); ++i)
+    job.blockLengths[i] = getU32(&buffers.blocks[4 * i]);
+  job.isValid = true;
+}
+
+void libcdr::CDRInflatePipeline::work()
+{
+  Buffers buffers;
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true)
+  {
+    // the list the parser waits for is always inflated
+    m_condition.wait(lock, [this]()
+    {
+      return m_isStopping || m_nextJob >= m_jobs.size() || m_queuedBytes < m_maxQueuedBytes || m_nextJob <= m_nextTaken;
+    });
+    if (m_isStopping)
+      return;
+    m_nextJob = std::max(m_nextJob, m_nextTaken);
+    if (m_nextJob >= m_jobs.size())
+      return;
+    const size_t index = m_nextJob++;
+    Job &job = m_jobs[index];
+    lock.unlock();
+    try
+    {
+      inflate(job, buffers);
+    }
+    catch (...)
+    {
+      job.isValid = false;
+    }
+    lock.lock();
+    if (!job.isValid || index < m_nextTaken)
+    {
+      job.data.reset();
+      job.dataSize = 0;
+      std::vector<unsigned>().swap(job.blockLengths);
+    }
+    else
+      m_queuedBytes += job.dataSize + job.blockLengths.size() * sizeof(unsigned);
+    job.isDone = true;
+    m_condition.notify_all();
+  }
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
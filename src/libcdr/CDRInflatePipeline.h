@@ -0,0 +1,110 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libcdr project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef __CDRINFLATEPIPELINE_H__
+#define __CDRINFLATEPIPELINE_H__
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <librevenge-stream/librevenge-stream.h>
+
+namespace libcdr
+{
+
+/* Inflates the cmpr lists of a document in background threads, ahead
+   of the parser.
+
+   The lists are located by walking the headers of the uncompressed
+   lists of the input, in the order the parser meets them. The workers
+   inflate them in that order, each one into its own buffer, while the
+   parser goes through the lists inflated before. The workers wait when
+   the inflated lists not yet taken by the parser hold more than
+   maxQueuedBytes, except for the list the parser waits for. */
+class CDRInflatePipeline
+{
+public:
+  /* threadCount 0 uses as many threads as the hardware runs at once.
+     Nothing is prefetched if input can neither be read at a given
+     offset nor cloned, nor are the lists inflating to more than
+     maxListSize bytes */
+  CDRInflatePipeline(librevenge::RVNGInputStream *input, unsigned threadCount, unsigned long maxQueuedBytes,
+                     unsigned long maxListSize = (unsigned long)-1);
+  ~CDRInflatePipeline();
+
+  /* Takes the inflated data and block lengths of the cmpr list whose
+     list type is at offset in the input, waiting for them if needed.
+     The lists before it which have not been taken are dropped.
+     Returns false if the list has not been prefetched, in which case
+     the caller has to inflate it itself */
+  bool take(unsigned long offset, std::shared_ptr<const unsigned char> &data, unsigned long &dataSize,
+            std::vector<unsigned> &blockLengths);
+
+private:
+  struct Job
+  {
+    Job()
+      : offset(0), compressedSize(0), uncompressedSize(0), blocksSize(0), uncompressedBlocksSize(0),
+        isDone(false), isValid(false), data(), dataSize(0), blockLengths() {}
+    unsigned long offset;
+    unsigned long compressedSize;
+    unsigned long uncompressedSize;
+    unsigned long blocksSize;
+    unsigned long uncompressedBlocksSize;
+    bool isDone;
+    bool isValid;
+    std::shared_ptr<const unsigned char> data;
+    unsigned long dataSize;
+    std::vector<unsigned> blockLengths;
+  };
+
+  /* Buffers reused by a worker from one list to the next */
+  struct Buffers
+  {
+    Buffers() : compressed(), blocks() {}
+    std::vector<unsigned char> compressed;
+    std::vector<unsigned char> blocks;
+  };
+
+  CDRInflatePipeline(const CDRInflatePipeline &);
+  CDRInflatePipeline &operator=(const CDRInflatePipeline &);
+
+  unsigned long readAt(unsigned long offset, unsigned long numBytes, unsigned char *buffer);
+  void findLists(unsigned long begin, unsigned long end, unsigned depth);
+  void inflate(Job &job, Buffers &buffers);
+  void work();
+
+  librevenge::RVNGInputStream *m_input;
+  std::unique_ptr<librevenge::RVNGInputStream> m_clone;
+  std::mutex m_cloneMutex;
+  bool m_hasReadAt;
+
+  std::vector<Job> m_jobs;
+  std::map<unsigned long, size_t> m_jobIndex;
+  /* The next job to start */
+  size_t m_nextJob;
+  /* The next job the parser can take; those before it are dropped */
+  size_t m_nextTaken;
+  unsigned long m_queuedBytes;
+  const unsigned long m_maxQueuedBytes;
+  const unsigned long m_maxListSize;
+  bool m_isStopping;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::vector<std::thread> m_threads;
+};
+
+} // namespace libcdr
+
+#endif // __CDRINFLATEPIPELINE_H__
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
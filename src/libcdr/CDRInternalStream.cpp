@@ -9,90 +9,83 @@
 
 #include "CDRInternalStream.h"
 
-#include <zlib.h>
-#include <string.h>  // for memcpy
+#include "../librevenge/RVNGInflate.h"
+#include "../librevenge/RVNGStreamBuffer.h"
 
+namespace
+{
+
+std::shared_ptr<const unsigned char> shareBuffer(std::vector<unsigned char> &&buffer)
+{
+  if (buffer.empty())
+    return std::shared_ptr<const unsigned char>();
+  auto owner = std::make_shared<const std::vector<unsigned char> >(std::move(buffer));
+  return std::shared_ptr<const unsigned char>(owner, &(*owner)[0]);
+}
 
-#define CHUNK 16384
+} // anonymous namespace
 
 libcdr::CDRInternalStream::CDRInternalStream(const std::vector<unsigned char> &buffer) :
   librevenge::RVNGInputStream(),
   m_offset(0),
-  m_buffer(buffer)
+  m_buffer(shareBuffer(std::vector<unsigned char>(buffer))),
+  m_size(m_buffer ? buffer.size() : 0)
+{
+}
+
+libcdr::CDRInternalStream::CDRInternalStream(const std::shared_ptr<const unsigned char> &data, unsigned long size) :
+  librevenge::RVNGInputStream(),
+  m_offset(0),
+  m_buffer(size ? data : std::shared_ptr<const unsigned char>()),
+  m_size(m_buffer ? size : 0)
 {
 }
 
-libcdr::CDRInternalStream::CDRInternalStream(librevenge::RVNGInputStream *input, unsigned long size, bool compressed) :
+libcdr::CDRInternalStream::CDRInternalStream(librevenge::RVNGInputStream *input, unsigned long size, bool compressed, unsigned long uncompressedSize,
+                                             unsigned long maxUncompressedSize) :
   librevenge::RVNGInputStream(),
   m_offset(0),
-  m_buffer()
+  m_buffer(),
+  m_size(0)
 {
   if (!size)
     return;
 
   if (!compressed)
   {
-    unsigned long tmpNumBytesRead = 0;
-    const unsigned char *tmpBuffer = input->read(size, tmpNumBytesRead);
-
-    if (size != tmpNumBytesRead)
-      return;
-
-    m_buffer = std::vector<unsigned char>(size);
-    memcpy(&m_buffer[0], tmpBuffer, size);
-  }
-  else
-  {
-    int ret;
-    z_stream strm;
-    unsigned char out[CHUNK];
-
-    /* allocate inflate state */
-    strm.zalloc = Z_NULL;
-    strm.zfree = Z_NULL;
-    strm.opaque = Z_NULL;
-    strm.avail_in = 0;
-    strm.next_in = Z_NULL;
-    ret = inflateInit(&strm);
-    if (ret != Z_OK)
-      return;
-
-    unsigned long tmpNumBytesRead = 0;
-    const unsigned char *tmpBuffer = input->read(size, tmpNumBytesRead);
-
-    if (size != tmpNumBytesRead)
+    std::shared_ptr<const unsigned char> slice;
+    const long position = input->tell();
+    if (auto internalStream = dynamic_cast<CDRInternalStream *>(input))
     {
-      (void)inflateEnd(&strm);
+      if (position >= 0 && static_cast<unsigned long>(position) <= internalStream->m_size && size <= internalStream->m_size - position)
+        slice = std::shared_ptr<const unsigned char>(internalStream->m_buffer, internalStream->m_buffer.get() + position);
+    }
+    else if (position >= 0)
+      slice = librevenge::RVNGStreamBuffer::getSlice(input, static_cast<unsigned long>(position), size);
+    if (slice)
+    {
+      input->seek(long(size), librevenge::RVNG_SEEK_CUR);
+      m_buffer = slice;
+      m_size = size;
       return;
     }
+  }
 
-    strm.avail_in = (uInt)tmpNumBytesRead;
-    strm.next_in = (Bytef *)tmpBuffer;
+  unsigned long tmpNumBytesRead = 0;
+  const unsigned char *tmpBuffer = input->read(size, tmpNumBytesRead);
 
-    do
-    {
-      strm.avail_out = CHUNK;
-      strm.next_out = out;
-      ret = inflate(&strm, Z_NO_FLUSH);
-      switch (ret)
-      {
-      case Z_NEED_DICT:
-      case Z_DATA_ERROR:
-      case Z_MEM_ERROR:
-        (void)inflateEnd(&strm);
-        m_buffer.clear();
-        return;
-      }
-
-      unsigned have = CHUNK - strm.avail_out;
-
-      for (unsigned long i=0; i<have; i++)
-        m_buffer.push_back(out[i]);
+  if (size != tmpNumBytesRead)
+    return;
 
-    }
-    while (strm.avail_out == 0);
-    (void)inflateEnd(&strm);
-  }
+  std::vector<unsigned char> buffer;
+  if (!compressed)
+    buffer.assign(tmpBuffer, tmpBuffer + size);
+  else if (librevenge::RVNGInflate::inflateBuffer(tmpBuffer, size, false, uncompressedSize, buffer, maxUncompressedSize)
+           == librevenge::RVNGInflate::Failed)
+    return;
+
+  m_size = buffer.size();
+  m_buffer = shareBuffer(std::move(buffer));
 }
 
 const unsigned char *libcdr::CDRInternalStream::read(unsigned long numBytes, unsigned long &numBytesRead)
@@ -104,10 +97,10 @@ const unsigned char *libcdr::CDRInternalStream::read(unsigned long numBytes, uns
 
   unsigned numBytesToRead;
 
-  if ((m_offset+numBytes) < m_buffer.size())
+  if ((m_offset+numBytes) < m_size)
     numBytesToRead = numBytes;
   else
-    numBytesToRead = m_buffer.size() - m_offset;
+    numBytesToRead = m_size - m_offset;
 
   numBytesRead = numBytesToRead; // about as paranoid as we can be..
 
@@ -117,7 +110,7 @@ const unsigned char *libcdr::CDRInternalStream::read(unsigned long numBytes, uns
   long oldOffset = m_offset;
   m_offset += numBytesToRead;
 
-  return &m_buffer[oldOffset];
+  return m_buffer.get() + oldOffset;
 }
 
 int libcdr::CDRInternalStream::seek(long offset, librevenge::RVNG_SEEK_TYPE seekType)
@@ -127,16 +120,16 @@ int libcdr::CDRInternalStream::seek(long offset, librevenge::RVNG_SEEK_TYPE seek
   else if (seekType == librevenge::RVNG_SEEK_SET)
     m_offset = offset;
   else if (seekType == librevenge::RVNG_SEEK_END)
-    m_offset = long(static_cast<unsigned long>(m_buffer.size())) + offset;
+    m_offset = long(static_cast<unsigned long>(m_size)) + offset;
 
   if (m_offset < 0)
   {
     m_offset = 0;
     return 1;
   }
-  if ((long)m_offset > (long)m_buffer.size())
+  if ((long)m_offset > (long)m_size)
   {
-    m_offset = m_buffer.size();
+    m_offset = m_size;
     return 1;
   }
 
@@ -150,7 +143,7 @@ long libcdr::CDRInternalStream::tell()
 
 bool libcdr::CDRInternalStream::isEnd()
 {
-  if ((long)m_offset >= (long)m_buffer.size())
+  if ((long)m_offset >= (long)m_size)
     return true;
 
   return false;
@@ -10,6 +10,7 @@
 #ifndef __CDRINTERNALSTREAM_H__
 #define __CDRINTERNALSTREAM_H__
 
+#include <memory>
 #include <vector>
 
 #include <librevenge-stream/librevenge-stream.h>
@@ -20,8 +21,18 @@ namespace libcdr
 class CDRInternalStream : public librevenge::RVNGInputStream
 {
 public:
-  CDRInternalStream(librevenge::RVNGInputStream *input, unsigned long size, bool compressed=false);
+  /* uncompressedSize, when known, lets the compressed data be inflated
+     into a buffer of the right size at once. Uncompressed data are not
+     copied if input keeps them in memory: the stream is then a view of
+     the data of input, bounded to size bytes. Compressed data are only
+     inflated up to maxUncompressedSize + 1 bytes, so a stream bigger
+     than maxUncompressedSize holds only the beginning of them */
+  CDRInternalStream(librevenge::RVNGInputStream *input, unsigned long size, bool compressed=false, unsigned long uncompressedSize=0,
+                    unsigned long maxUncompressedSize=(unsigned long)-1);
   CDRInternalStream(const std::vector<unsigned char> &buffer);
+  /* Creates a stream reading the size bytes at data, sharing their
+     ownership instead of copying them */
+  CDRInternalStream(const std::shared_ptr<const unsigned char> &data, unsigned long size);
   ~CDRInternalStream() override {}
 
   bool isStructured() override
@@ -54,12 +65,18 @@ public:
   bool isEnd() override;
   unsigned long getSize() const
   {
-    return m_buffer.size();
+    return m_size;
+  }
+  /* The data of the stream, which can be shared with other streams */
+  const std::shared_ptr<const unsigned char> &getBuffer() const
+  {
+    return m_buffer;
   }
 
 private:
   volatile long m_offset;
-  std::vector<unsigned char> m_buffer;
+  std::shared_ptr<const unsigned char> m_buffer;
+  unsigned long m_size;
   CDRInternalStream(const CDRInternalStream &);
   CDRInternalStream &operator=(const CDRInternalStream &);
 };
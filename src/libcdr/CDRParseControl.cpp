@@ -0,0 +1,102 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libcdr project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <atomic>
+
+#include <libcdr/CDRParseControl.h>
+
+namespace libcdr
+{
+
+class CDRParseControlImpl
+{
+public:
+  CDRParseControlImpl()
+    : m_isCancelled(false), m_timeLimit(0), m_inflateLimit(0), m_pathPointLimit(0), m_result(CDR_PARSE_OK) {}
+
+  std::atomic<bool> m_isCancelled;
+  unsigned long m_timeLimit;
+  unsigned long m_inflateLimit;
+  unsigned long m_pathPointLimit;
+  std::atomic<int> m_result;
+};
+
+} // namespace libcdr
+
+libcdr::CDRParseControl::CDRParseControl()
+  : m_impl(new CDRParseControlImpl())
+{
+}
+
+libcdr::CDRParseControl::~CDRParseControl()
+{
+  delete m_impl;
+}
+
+/**
+Does nothing; override it to follow the parse.
+\param bytesDone The bytes of the document read so far
+\param bytesTotal The size of the document
+\param pagesDone The pages drawn so far
+*/
+void libcdr::CDRParseControl::progress(unsigned long, unsigned long, unsigned)
+{
+}
+
+void libcdr::CDRParseControl::cancel()
+{
+  m_impl->m_isCancelled = true;
+}
+
+bool libcdr::CDRParseControl::isCancelled() const
+{
+  return m_impl->m_isCancelled;
+}
+
+void libcdr::CDRParseControl::setTimeLimit(unsigned long milliseconds)
+{
+  m_impl->m_timeLimit = milliseconds;
+}
+
+unsigned long libcdr::CDRParseControl::getTimeLimit() const
+{
+  return m_impl->m_timeLimit;
+}
+
+void libcdr::CDRParseControl::setInflateLimit(unsigned long bytes)
+{
+  m_impl->m_inflateLimit = bytes;
+}
+
+unsigned long libcdr::CDRParseControl::getInflateLimit() const
+{
+  return m_impl->m_inflateLimit;
+}
+
+void libcdr::CDRParseControl::setPathPointLimit(unsigned long points)
+{
+  m_impl->m_pathPointLimit = points;
+}
+
+unsigned long libcdr::CDRParseControl::getPathPointLimit() const
+{
+  return m_impl->m_pathPointLimit;
+}
+
+libcdr::CDRParseResult libcdr::CDRParseControl::getResult() const
+{
+  return CDRParseResult(m_impl->m_result.load());
+}
+
+void libcdr::CDRParseControl::setResult(CDRParseResult result)
+{
+  m_impl->m_result = result;
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,143 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libcdr project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "CDRParseTracker.h"
+
+#include <algorithm>
+
+namespace
+{
+
+/* The progress is reported about every percent of the document, but
+   not more often than every so many bytes */
+static const unsigned long MIN_REPORT_STEP = 64 * 1024;
+
+} // anonymous namespace
+
+libcdr::CDRParseTracker::CDRParseTracker(CDRParseControl &control) :
+  m_control(control),
+  m_hasDeadline(control.getTimeLimit() != 0),
+  m_deadline(std::chrono::steady_clock::now() + std::chrono::milliseconds(control.getTimeLimit())),
+  m_inflateLimit(control.getInflateLimit()),
+  m_pathPointLimit(control.getPathPointLimit()),
+  m_reason(CDR_PARSE_OK),
+  m_totalBytes(0),
+  m_bytesDone(0),
+  m_nextReport(0),
+  m_inflated(0),
+  m_pathPoints(0),
+  m_pagesDone(0),
+  m_progressMutex()
+{
+  m_control.setResult(CDR_PARSE_OK);
+}
+
+void libcdr::CDRParseTracker::setTotalBytes(unsigned long totalBytes)
+{
+  m_totalBytes = totalBytes;
+}
+
+bool libcdr::CDRParseTracker::checkRecord(long position)
+{
+  if (isStopped())
+    return false;
+  if (m_control.isCancelled())
+    return stop(CDR_PARSE_CANCELLED);
+  if (m_hasDeadline && std::chrono::steady_clock::now() > m_deadline)
+    return stop(CDR_PARSE_TIME_LIMIT);
+  if (position >= 0)
+  {
+    const auto bytesDone = (unsigned long)position;
+    unsigned long previous = m_bytesDone;
+    while (previous < bytesDone && !m_bytesDone.compare_exchange_weak(previous, bytesDone))
+    {
+    }
+    if (bytesDone >= m_nextReport)
+      report();
+  }
+  return true;
+}
+
+unsigned long libcdr::CDRParseTracker::getInflateBudget() const
+{
+  if (!m_inflateLimit)
+    return (unsigned long)-1;
+  const unsigned long inflated = m_inflated;
+  return inflated < m_inflateLimit ? m_inflateLimit - inflated : 0;
+}
+
+bool libcdr::CDRParseTracker::addInflated(unsigned long size)
+{
+  if (m_inflateLimit && (m_inflated += size) > m_inflateLimit)
+    return stop(CDR_PARSE_INFLATE_LIMIT);
+  return !isStopped();
+}
+
+bool libcdr::CDRParseTracker::addPathPoints(unsigned long count)
+{
+  if (m_pathPointLimit && (m_pathPoints += count) > m_pathPointLimit)
+    return stop(CDR_PARSE_POINT_LIMIT);
+  return !isStopped();
+}
+
+void libcdr::CDRParseTracker::endPage()
+{
+  ++m_pagesDone;
+  report();
+}
+
+bool libcdr::CDRParseTracker::isStopped() const
+{
+  return m_reason != CDR_PARSE_OK;
+}
+
+bool libcdr::CDRParseTracker::finish(bool parsed)
+{
+  // the last report can still cancel the parse
+  if (parsed && !isStopped())
+  {
+    m_bytesDone = m_totalBytes.load();
+    report();
+  }
+  const int reason = m_reason;
+  if (reason != CDR_PARSE_OK)
+  {
+    m_control.setResult(CDRParseResult(reason));
+    return false;
+  }
+  m_control.setResult(parsed ? CDR_PARSE_OK : CDR_PARSE_FAILED);
+  return parsed;
+}
+
+bool libcdr::CDRParseTracker::stop(CDRParseResult reason)
+{
+  int running = CDR_PARSE_OK;
+  m_reason.compare_exchange_strong(running, reason);
+  return false;
+}
+
+void libcdr::CDRParseTracker::report()
+{
+  std::lock_guard<std::mutex> lock(m_progressMutex);
+  const unsigned long totalBytes = m_totalBytes;
+  const unsigned long bytesDone = std::min(m_bytesDone.load(), totalBytes);
+  m_nextReport = bytesDone + std::max(totalBytes / 100, MIN_REPORT_STEP);
+  try
+  {
+    m_control.progress(bytesDone, totalBytes, m_pagesDone);
+  }
+  catch (...)
+  {
+    // the exception cannot go through the parsers and the threads, so
+    // it cancels the parse instead
+    stop(CDR_PARSE_CANCELLED);
+  }
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,73 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libcdr project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef __CDRPARSETRACKER_H__
+#define __CDRPARSETRACKER_H__
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#include <libcdr/CDRParseControl.h>
+
+namespace libcdr
+{
+
+/* Follows one parse for its CDRParseControl: counts what the parse
+   goes through, reports the progress and decides when it has to stop.
+
+   Once a limit is reached or the parse is cancelled, the tracker stays
+   stopped, and every check returns false. The parsers check it at every
+   record and return false, which ends the parse the way a broken record
+   does. The threads collecting the pages share the tracker. */
+class CDRParseTracker
+{
+public:
+  explicit CDRParseTracker(CDRParseControl &control);
+
+  void setTotalBytes(unsigned long totalBytes);
+  /* Called before every record. position is the offset of the record
+     in the document, or -1 if it is not known */
+  bool checkRecord(long position);
+  /* How many more bytes can be inflated */
+  unsigned long getInflateBudget() const;
+  bool addInflated(unsigned long size);
+  bool addPathPoints(unsigned long count);
+  void endPage();
+  bool isStopped() const;
+  /* Sets the result of the control; returns false if the parse was stopped */
+  bool finish(bool parsed);
+
+private:
+  CDRParseTracker(const CDRParseTracker &);
+  CDRParseTracker &operator=(const CDRParseTracker &);
+
+  bool stop(CDRParseResult reason);
+  void report();
+
+  CDRParseControl &m_control;
+  const bool m_hasDeadline;
+  const std::chrono::steady_clock::time_point m_deadline;
+  const unsigned long m_inflateLimit;
+  const unsigned long m_pathPointLimit;
+  /* CDR_PARSE_OK while the parse goes on */
+  std::atomic<int> m_reason;
+  std::atomic<unsigned long> m_totalBytes;
+  std::atomic<unsigned long> m_bytesDone;
+  std::atomic<unsigned long> m_nextReport;
+  std::atomic<unsigned long> m_inflated;
+  std::atomic<unsigned long> m_pathPoints;
+  std::atomic<unsigned> m_pagesDone;
+  std::mutex m_progressMutex;
+};
+
+} // namespace libcdr
+
+#endif // __CDRPARSETRACKER_H__
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -25,6 +25,10 @@
 #include "libcdr_utils.h"
 #include "CDRDocumentStructure.h"
 #include "CDRInternalStream.h"
+#include "CDRRecordCursor.h"
+#include "CDRInflatePipeline.h"
+#include "CDRParseTracker.h"
+#include "CDRRecordTape.h"
 #include "CDRCollector.h"
 #include "CDRColorPalettes.h"
 
@@ -214,11 +218,51 @@ void normalizeAngle(double &angle)
     angle += 2*M_PI;
 }
 
+/* The records holding bitmaps, patterns, fonts, texts and their styles,
+   which the geometry-only parses skip */
+bool isSkippedForGeometry(unsigned fourCC)
+{
+  switch (fourCC)
+  {
+  case CDR_FOURCC_bmp:
+  case CDR_FOURCC_bmpf:
+  case CDR_FOURCC_vpat:
+  case CDR_FOURCC_txsm:
+  case CDR_FOURCC_stlt:
+  case CDR_FOURCC_font:
+  case CDR_FOURCC_iccd:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/* The records whose content only the styles pass keeps, the content
+   collector ignoring it */
+bool isStylesRecord(unsigned fourCC)
+{
+  switch (fourCC)
+  {
+  case CDR_FOURCC_bmp:
+  case CDR_FOURCC_bmpf:
+  case CDR_FOURCC_iccd:
+  case CDR_FOURCC_mcfg:
+  case CDR_FOURCC_uidr:
+  case CDR_FOURCC_txsm:
+    return true;
+  default:
+    return false;
+  }
+}
+
 } // anonymous namespace
 
 libcdr::CDRParser::CDRParser(const std::vector<std::unique_ptr<librevenge::RVNGInputStream>> &externalStreams, libcdr::CDRCollector *collector)
   : CommonParser(collector), m_externalStreams(externalStreams),
-    m_fonts(), m_fillStyles(), m_lineStyles(), m_arrows(), m_version(0), m_waldoOutlId(0), m_waldoFillId(0) {}
+    m_fonts(), m_fillStyles(), m_lineStyles(), m_arrows(), m_version(0), m_waldoOutlId(0), m_waldoFillId(0),
+    m_tape(nullptr), m_tapeStream(CDRRecordTape::INPUT_STREAM), m_structureOnly(false),
+    m_skipStylesRecords(false), m_inflatePipeline(nullptr), m_options(), m_inputOffset(0),
+    m_cmprInputOffset(-1), m_cmprInputLength(0), m_cmprLength(0) {}
 
 libcdr::CDRParser::~CDRParser()
 {
@@ -404,6 +448,8 @@ bool libcdr::CDRParser::parseWaldoStructure(librevenge::RVNGInputStream *input,
   std::set<unsigned> visited;
   while (!waldoStack.empty() && visited.insert(waldoStack.top().m_id).second)
   {
+    if (m_tracker && !m_tracker->checkRecord(-1))
+      return false;
     m_collector->collectBBox(waldoStack.top().m_x0, waldoStack.top().m_y0, waldoStack.top().m_x1, waldoStack.top().m_y1);
     std::map<unsigned, WaldoRecordType1>::const_iterator iter1;
     if (waldoStack.top().m_flags & 0x01)
@@ -447,6 +493,9 @@ bool libcdr::CDRParser::parseWaldoStructure(librevenge::RVNGInputStream *input,
 void libcdr::CDRParser::readWaldoRecord(librevenge::RVNGInputStream *input, const WaldoRecordInfo &info)
 {
   CDR_DEBUG_MSG(("CDRParser::readWaldoRecord, type %i, id %x, offset %x\n", info.type, info.id, info.offset));
+  // the bitmaps and the bitmap patterns
+  if (m_options.geometryOnly && (info.type == 3 || info.type == 6))
+    return;
   input->seek(info.offset, librevenge::RVNG_SEEK_SET);
   switch (info.type)
   {
@@ -533,16 +582,20 @@ void libcdr::CDRParser::readWaldoLoda(librevenge::RVNGInputStream *input, unsign
   if (shapeOffset)
   {
     input->seek(startPosition + shapeOffset, librevenge::RVNG_SEEK_SET);
+    // the coordinates of these versions always have 16 bits
+    CDRStreamCursor<false, PRECISION_16BIT> cursor(input);
     if (chunkType == 0x00) // Rectangle
-      readRectangle(input);
+      readRectangle(cursor);
     else if (chunkType == 0x01) // Ellipse
-      readEllipse(input);
+      readEllipse(cursor);
     else if (chunkType == 0x02) // Line and curve
-      readLineAndCurve(input);
+      readLineAndCurve(cursor);
     /* else if (chunkType == 0x03) // Text
             readText(input); */
     else if (chunkType == 0x04) // Bitmap
       readBitmap(input);
+    if (cursor.hasFailed())
+      throw EndOfStreamException();
   }
   input->seek(startPosition + length, librevenge::RVNG_SEEK_SET);
 }
@@ -554,6 +607,8 @@ bool libcdr::CDRParser::parseRecords(librevenge::RVNGInputStream *input, const s
     return false;
   }
   m_collector->collectLevel(level);
+  if (m_tape)
+    m_tape->addLevel(level, getInputPosition(input));
   while (!input->isEnd())
   {
     if (!parseRecord(input, blockLengths, level))
@@ -562,6 +617,94 @@ bool libcdr::CDRParser::parseRecords(librevenge::RVNGInputStream *input, const s
   return true;
 }
 
+void libcdr::CDRParser::setRecordTape(CDRRecordTape *tape, bool structureOnly)
+{
+  m_tape = tape;
+  m_tapeStream = CDRRecordTape::INPUT_STREAM;
+  m_structureOnly = tape && structureOnly;
+}
+
+void libcdr::CDRParser::setInflatePipeline(CDRInflatePipeline *pipeline)
+{
+  m_inflatePipeline = pipeline;
+}
+
+void libcdr::CDRParser::setParseOptions(const CDRParseOptions &options)
+{
+  m_options = options;
+}
+
+void libcdr::CDRParser::setSkipStylesRecords(bool skip)
+{
+  m_skipStylesRecords = skip;
+}
+
+bool libcdr::CDRParser::replayRecords(librevenge::RVNGInputStream *input, const CDRRecordTape &tape, unsigned firstPage, unsigned lastPage)
+{
+  if (!input)
+    return false;
+  const std::vector<CDRRecordTape::Entry> &entries = tape.getEntries();
+  const std::vector<CDRRecordTape::Page> &pages = tape.getPages();
+  size_t page = 0;
+  std::unique_ptr<librevenge::RVNGInputStream> stream;
+  unsigned streamId = CDRRecordTape::INPUT_STREAM;
+  try
+  {
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+      const CDRRecordTape::Entry &entry = entries[i];
+      if (m_tracker && !m_tracker->checkRecord(entry.position))
+        return false;
+      if (page < pages.size() && pages[page].begin == i)
+      {
+        if (page < firstPage || page > lastPage)
+        {
+          // still close what the previous page left open
+          m_collector->collectLevel(entry.level);
+          i = pages[page++].end - 1;
+          continue;
+        }
+        ++page;
+      }
+      m_collector->collectLevel(entry.level);
+      if (!entry.fourCC)
+        continue;
+      if (entry.fourCC == CDR_FOURCC_RIFF || entry.fourCC == CDR_FOURCC_LIST)
+      {
+        m_collector->collectOtherList();
+        if (entry.listType != CDR_FOURCC_cmpr)
+          collectListType(entry.listType, entry.level);
+        continue;
+      }
+      if (entry.stream != streamId)
+      {
+        streamId = entry.stream;
+        stream.reset(tape.createStream(streamId));
+      }
+      librevenge::RVNGInputStream *recordInput = stream ? stream.get() : input;
+      recordInput->seek(entry.offset, librevenge::RVNG_SEEK_SET);
+      if (!readRecord(entry.fourCC, entry.length, recordInput))
+        return false;
+    }
+  }
+  catch (...)
+  {
+    return false;
+  }
+  return true;
+}
+
+long libcdr::CDRParser::getInputPosition(librevenge::RVNGInputStream *input) const
+{
+  if (m_inputOffset < 0)
+    return m_cmprInputOffset;
+  const long position = m_inputOffset + input->tell();
+  if (!m_cmprLength)
+    return position;
+  // the records of a cmpr list are spread over its compressed data
+  return m_cmprInputOffset + long(double(position) * m_cmprInputLength / m_cmprLength);
+}
+
 bool libcdr::CDRParser::parseRecord(librevenge::RVNGInputStream *input, const std::vector<unsigned> &blockLengths, unsigned level)
 {
   if (!input)
@@ -570,6 +713,9 @@ bool libcdr::CDRParser::parseRecord(librevenge::RVNGInputStream *input, const st
   }
   try
   {
+    const long recordPosition = getInputPosition(input);
+    if (m_tracker && !m_tracker->checkRecord(recordPosition))
+      return false;
     m_collector->collectLevel(level);
     while (!input->isEnd() && readU8(input) == 0)
     {
@@ -577,7 +723,11 @@ bool libcdr::CDRParser::parseRecord(librevenge::RVNGInputStream *input, const st
     if (!input->isEnd())
       input->seek(-1, librevenge::RVNG_SEEK_CUR);
     else
+    {
+      if (m_tape)
+        m_tape->addLevel(level, getInputPosition(input));
       return true;
+    }
     unsigned fourCC = readU32(input);
     unsigned length = readU32(input);
     if (blockLengths.size() > length)
@@ -597,11 +747,17 @@ bool libcdr::CDRParser::parseRecord(librevenge::RVNGInputStream *input, const st
     if (fourCC == CDR_FOURCC_RIFF || fourCC == CDR_FOURCC_LIST)
     {
       CDR_DEBUG_MSG(("CDR listType: %s\n", toFourCC(listType)));
+      if (m_tape)
+        m_tape->addList(level, fourCC, listType, recordPosition);
       unsigned cmprsize = length-4;
+      unsigned uncmprsize = 0;
+      unsigned uncmprblcksize = 0;
       if (listType == CDR_FOURCC_cmpr)
       {
         cmprsize  = readU32(input);
-        input->seek(12, librevenge::RVNG_SEEK_CUR);
+        uncmprsize = readU32(input);
+        input->seek(4, librevenge::RVNG_SEEK_CUR); // compressed size of the block lengths
+        uncmprblcksize = readU32(input);
         if (readU32(input) != CDR_FOURCC_CPng)
           return false;
         if (readU16(input) != 1)
@@ -609,43 +765,83 @@ bool libcdr::CDRParser::parseRecord(librevenge::RVNGInputStream *input, const st
         if (readU16(input) != 4)
           return false;
       }
-      else if (listType == CDR_FOURCC_page)
-        m_collector->collectPage(level);
-      else if (listType == CDR_FOURCC_obj)
-        m_collector->collectObject(level);
-      else if (listType == CDR_FOURCC_grp || listType == CDR_FOURCC_lnkg)
-        m_collector->collectGroup(level);
-      else if ((listType & 0xffffff) == CDR_FOURCC_CDR || (listType & 0xffffff) == CDR_FOURCC_cdr)
-      {
-        m_version = getCDRVersion((listType & 0xff000000) >> 24);
-        if (m_version < 600)
-          m_precision = libcdr::PRECISION_16BIT;
-        else
-          m_precision = libcdr::PRECISION_32BIT;
-      }
-      else if (listType == CDR_FOURCC_vect || listType == CDR_FOURCC_clpt)
-        m_collector->collectVect(level);
+      else
+        collectListType(listType, level);
 
       bool compressed = (listType == CDR_FOURCC_cmpr ? true : false);
-      CDRInternalStream tmpStream(input, cmprsize, compressed);
+      std::vector<unsigned> tmpBlockLengths;
+      std::shared_ptr<const unsigned char> inflatedData;
+      unsigned long inflatedSize = 0;
+      const bool prefetched = compressed && m_inflatePipeline && m_inputOffset >= 0 && m_cmprInputOffset < 0
+                              && m_inflatePipeline->take(m_inputOffset + position, inflatedData, inflatedSize, tmpBlockLengths);
+      // the list is only copied if input does not keep its data in memory
+      const unsigned long inflateBudget = m_tracker ? m_tracker->getInflateBudget() : (unsigned long)-1;
+      std::unique_ptr<CDRInternalStream> tmpStream(prefetched ? new CDRInternalStream(inflatedData, inflatedSize)
+                                                   : new CDRInternalStream(input, cmprsize, compressed, uncmprsize, inflateBudget));
+      if (compressed && m_tracker && !m_tracker->addInflated(tmpStream->getSize()))
+        return false;
+      const unsigned parentTapeStream = m_tapeStream;
+      const long parentInputOffset = m_inputOffset;
+      const long parentCmprInputOffset = m_cmprInputOffset;
+      const unsigned long parentCmprInputLength = m_cmprInputLength;
+      const unsigned long parentCmprLength = m_cmprLength;
+      if (m_tape)
+        m_tapeStream = m_tape->addStream(*tmpStream);
+      bool parsed = false;
       if (!compressed)
       {
-        if (!parseRecords(&tmpStream, blockLengths, level+1))
-          return false;
+        if (m_inputOffset >= 0)
+          m_inputOffset += long(position) + 4;
+        parsed = parseRecords(tmpStream.get(), blockLengths, level+1);
       }
       else
       {
-        std::vector<unsigned> tmpBlockLengths;
-        unsigned blocksLength = length + position - input->tell();
-        CDRInternalStream tmpBlocksStream(input, blocksLength, compressed);
-        while (!tmpBlocksStream.isEnd())
-          tmpBlockLengths.push_back(readU32(&tmpBlocksStream));
-        if (!parseRecords(&tmpStream, tmpBlockLengths, level+1))
+        if (!prefetched)
+        {
+          unsigned blocksLength = length + position - input->tell();
+          CDRInternalStream tmpBlocksStream(input, blocksLength, compressed, uncmprblcksize,
+                                            m_tracker ? m_tracker->getInflateBudget() : (unsigned long)-1);
+          if (m_tracker && !m_tracker->addInflated(tmpBlocksStream.getSize()))
+            return false;
+          while (!tmpBlocksStream.isEnd())
+            tmpBlockLengths.push_back(readU32(&tmpBlocksStream));
+        }
+        else if (m_tracker && !m_tracker->addInflated(tmpBlockLengths.size() * 4))
           return false;
+        if (m_inputOffset >= 0 && m_cmprInputOffset < 0 && tmpStream->getSize())
+        {
+          m_cmprInputOffset = m_inputOffset + long(position);
+          m_cmprInputLength = length;
+          m_cmprLength = tmpStream->getSize();
+          m_inputOffset = 0;
+        }
+        else
+        {
+          // a nested or a misplaced list only reports where it starts
+          m_cmprInputOffset = recordPosition;
+          m_cmprLength = 0;
+          m_inputOffset = -1;
+        }
+        parsed = parseRecords(tmpStream.get(), tmpBlockLengths, level+1);
       }
+      m_tapeStream = parentTapeStream;
+      m_inputOffset = parentInputOffset;
+      m_cmprInputOffset = parentCmprInputOffset;
+      m_cmprInputLength = parentCmprInputLength;
+      m_cmprLength = parentCmprLength;
+      if (!parsed)
+        return false;
     }
     else
-      readRecord(fourCC, length, input);
+    {
+      if (m_tape)
+        m_tape->addRecord(level, fourCC, m_tapeStream, input->tell(), length, recordPosition);
+      // the version decides how the lists are read, and the flags which
+      // pages are drawn, so they are needed even when only the structure
+      // is recorded
+      if ((!m_structureOnly || fourCC == CDR_FOURCC_vrsn || fourCC == CDR_FOURCC_flgs) && !readRecord(fourCC, length, input))
+        return false;
+    }
 
     input->seek(position + length, librevenge::RVNG_SEEK_SET);
     return true;
@@ -656,9 +852,35 @@ bool libcdr::CDRParser::parseRecord(librevenge::RVNGInputStream *input, const st
   }
 }
 
-void libcdr::CDRParser::readRecord(unsigned fourCC, unsigned length, librevenge::RVNGInputStream *input)
+void libcdr::CDRParser::collectListType(unsigned listType, unsigned level)
+{
+  if (listType == CDR_FOURCC_page)
+    m_collector->collectPage(level);
+  else if (listType == CDR_FOURCC_obj)
+    m_collector->collectObject(level);
+  else if (listType == CDR_FOURCC_grp || listType == CDR_FOURCC_lnkg)
+    m_collector->collectGroup(level);
+  else if ((listType & 0xffffff) == CDR_FOURCC_CDR || (listType & 0xffffff) == CDR_FOURCC_cdr)
+  {
+    m_version = getCDRVersion((listType & 0xff000000) >> 24);
+    if (m_version < 600)
+      m_precision = libcdr::PRECISION_16BIT;
+    else
+      m_precision = libcdr::PRECISION_32BIT;
+  }
+  else if (listType == CDR_FOURCC_vect || listType == CDR_FOURCC_clpt)
+    m_collector->collectVect(level);
+}
+
+bool libcdr::CDRParser::readRecord(unsigned fourCC, unsigned length, librevenge::RVNGInputStream *input)
 {
+  // the callers go to the next record by its length
+  if (m_options.geometryOnly && isSkippedForGeometry(fourCC))
+    return true;
+  if (m_skipStylesRecords && isStylesRecord(fourCC))
+    return true;
   long recordStart = input->tell();
+  bool isValid = true;
   switch (fourCC)
   {
   case CDR_FOURCC_DISP:
@@ -666,14 +888,13 @@ void libcdr::CDRParser::readRecord(unsigned fourCC, unsigned length, librevenge:
     break;
   case CDR_FOURCC_loda:
   case CDR_FOURCC_lobj:
-    readLoda(input, length);
+  case CDR_FOURCC_trfd:
+  case CDR_FOURCC_bbox:
+    isValid = readRecordWithCursor(fourCC, length, input);
     break;
   case CDR_FOURCC_vrsn:
     readVersion(input, length);
     break;
-  case CDR_FOURCC_trfd:
-    readTrfd(input, length);
-    break;
   case CDR_FOURCC_outl:
     readOutl(input, length);
     break;
@@ -705,9 +926,6 @@ void libcdr::CDRParser::readRecord(unsigned fourCC, unsigned length, librevenge:
   case CDR_FOURCC_iccd:
     readIccd(input, length);
     break;
-  case CDR_FOURCC_bbox:
-    readBBox(input, length);
-    break;
   case CDR_FOURCC_spnd:
     readSpnd(input, length);
     break;
@@ -725,7 +943,8 @@ void libcdr::CDRParser::readRecord(unsigned fourCC, unsigned length, librevenge:
     break;
   case CDR_FOURCC_txsm:
   	#ifdef CRD_ANALYSIS_FONT
-    readTxsm(input, length);
+    if (m_options.analyseText)
+      readTxsm(input, length);
 	#endif
     break;
   case CDR_FOURCC_udta:
@@ -737,14 +956,75 @@ void libcdr::CDRParser::readRecord(unsigned fourCC, unsigned length, librevenge:
   default:
     break;
   }
+  if (!isValid)
+    return false;
   input->seek(recordStart + length, librevenge::RVNG_SEEK_CUR);
+  return true;
 }
 
-double libcdr::CDRParser::readRectCoord(librevenge::RVNGInputStream *input)
+bool libcdr::CDRParser::readRecordWithCursor(unsigned fourCC, unsigned length, librevenge::RVNGInputStream *input)
+{
+  if (!_redirectX6Chunk(&input, length))
+    return false;
+  const unsigned char *data = nullptr;
+  unsigned long size = 0;
+  const bool isInMemory = getMemorySpan(input, data, size);
+  if (m_precision == PRECISION_16BIT)
+  {
+    if (isInMemory)
+    {
+      CDRRecordCursor<false, PRECISION_16BIT> cursor(data, size);
+      return readCursorRecord(fourCC, length, cursor, input);
+    }
+    else
+    {
+      CDRStreamCursor<false, PRECISION_16BIT> cursor(input);
+      return readCursorRecord(fourCC, length, cursor, input);
+    }
+  }
+  else if (m_precision == PRECISION_32BIT)
+  {
+    if (isInMemory)
+    {
+      CDRRecordCursor<false, PRECISION_32BIT> cursor(data, size);
+      return readCursorRecord(fourCC, length, cursor, input);
+    }
+    else
+    {
+      CDRStreamCursor<false, PRECISION_32BIT> cursor(input);
+      return readCursorRecord(fourCC, length, cursor, input);
+    }
+  }
+  return false;
+}
+
+template<class Cursor>
+bool libcdr::CDRParser::readCursorRecord(unsigned fourCC, unsigned length, Cursor &cursor, librevenge::RVNGInputStream *input)
+{
+  switch (fourCC)
+  {
+  case CDR_FOURCC_loda:
+  case CDR_FOURCC_lobj:
+    readLoda(cursor, input, length);
+    break;
+  case CDR_FOURCC_trfd:
+    readTrfd(cursor, length);
+    break;
+  case CDR_FOURCC_bbox:
+    readBBox(cursor);
+    break;
+  default:
+    break;
+  }
+  return !cursor.hasFailed();
+}
+
+template<class Cursor>
+double libcdr::CDRParser::readRectCoord(Cursor &cursor)
 {
   if (m_version < 1500)
-    return readCoordinate(input);
-  return readDouble(input) / 254000.0;
+    return cursor.readCoordinate();
+  return cursor.readDouble() / 254000.0;
 }
 
 libcdr::CDRColor libcdr::CDRParser::readColor(librevenge::RVNGInputStream *input)
@@ -798,10 +1078,11 @@ libcdr::CDRColor libcdr::CDRParser::readColor(librevenge::RVNGInputStream *input
   return tmpColor;
 }
 
-void libcdr::CDRParser::readRectangle(librevenge::RVNGInputStream *input)
+template<class Cursor>
+void libcdr::CDRParser::readRectangle(Cursor &cursor)
 {
-  double x0 = readRectCoord(input);
-  double y0 = readRectCoord(input);
+  double x0 = readRectCoord(cursor);
+  double y0 = readRectCoord(cursor);
   double r3 = 0.0;
   double r2 = 0.0;
   double r1 = 0.0;
@@ -812,31 +1093,31 @@ void libcdr::CDRParser::readRectangle(librevenge::RVNGInputStream *input)
 
   if (m_version < 1500)
   {
-    r3 = readRectCoord(input);
-    r2 = m_version < 900 ? r3 : readRectCoord(input);
-    r1 = m_version < 900 ? r3 : readRectCoord(input);
-    r0 = m_version < 900 ? r3 : readRectCoord(input);
+    r3 = readRectCoord(cursor);
+    r2 = m_version < 900 ? r3 : readRectCoord(cursor);
+    r1 = m_version < 900 ? r3 : readRectCoord(cursor);
+    r0 = m_version < 900 ? r3 : readRectCoord(cursor);
   }
   else
   {
-    double scale = readDouble(input);
+    double scale = cursor.readDouble();
     if (scale != 0)
       scaleX = scale;
-    scale = readDouble(input);
+    scale = cursor.readDouble();
     if (scale != 0)
       scaleY = scale;
-    unsigned int scale_with = readU8(input);
-    input->seek(7, librevenge::RVNG_SEEK_CUR);
+    unsigned int scale_with = cursor.readU8();
+    cursor.skip(7);
     if (scale_with == 0)
     {
-      r3 = readDouble(input);
-      corner_type = readU8(input);
-      input->seek(15, librevenge::RVNG_SEEK_CUR);
-      r2 = readDouble(input);
-      input->seek(16, librevenge::RVNG_SEEK_CUR);
-      r1 = readDouble(input);
-      input->seek(16, librevenge::RVNG_SEEK_CUR);
-      r0 = readDouble(input);
+      r3 = cursor.readDouble();
+      corner_type = cursor.readU8();
+      cursor.skip(15);
+      r2 = cursor.readDouble();
+      cursor.skip(16);
+      r1 = cursor.readDouble();
+      cursor.skip(16);
+      r0 = cursor.readDouble();
 
       double width = fabs(x0*scaleX / 2.0);
       double height = fabs(y0*scaleY / 2.0);
@@ -847,14 +1128,14 @@ void libcdr::CDRParser::readRectangle(librevenge::RVNGInputStream *input)
     }
     else
     {
-      r3 = readRectCoord(input);
-      corner_type = readU8(input);
-      input->seek(15, librevenge::RVNG_SEEK_CUR);
-      r2 = readRectCoord(input);
-      input->seek(16, librevenge::RVNG_SEEK_CUR);
-      r1 = readRectCoord(input);
-      input->seek(16, librevenge::RVNG_SEEK_CUR);
-      r0 = readRectCoord(input);
+      r3 = readRectCoord(cursor);
+      corner_type = cursor.readU8();
+      cursor.skip(15);
+      r2 = readRectCoord(cursor);
+      cursor.skip(16);
+      r1 = readRectCoord(cursor);
+      cursor.skip(16);
+      r0 = readRectCoord(cursor);
     }
   }
   CDRPath path;
@@ -911,18 +1192,22 @@ void libcdr::CDRParser::readRectangle(librevenge::RVNGInputStream *input)
   else
     path.appendLineTo(0.0, 0.0);
   path.appendClosePath();
-  m_collector->collectPath(path);
+  if (!cursor.hasFailed())
+    m_collector->collectPath(path);
 }
 
-void libcdr::CDRParser::readEllipse(librevenge::RVNGInputStream *input)
+template<class Cursor>
+void libcdr::CDRParser::readEllipse(Cursor &cursor)
 {
   CDR_DEBUG_MSG(("CDRParser::readEllipse\n"));
 
-  double x = readCoordinate(input);
-  double y = readCoordinate(input);
-  double angle1 = readAngle(input);
-  double angle2 = readAngle(input);
-  bool pie(0 != readUnsigned(input));
+  double x = cursor.readCoordinate();
+  double y = cursor.readCoordinate();
+  double angle1 = cursor.readAngle();
+  double angle2 = cursor.readAngle();
+  bool pie(0 != cursor.readUnsigned());
+  if (cursor.hasFailed())
+    return;
 
   double cx = x/2.0;
   double cy = y/2.0;
@@ -1014,57 +1299,49 @@ void libcdr::CDRParser::readDisp(librevenge::RVNGInputStream *input, unsigned le
 #endif
 }
 
-void libcdr::CDRParser::readLineAndCurve(librevenge::RVNGInputStream *input)
+template<class Cursor>
+void libcdr::CDRParser::readLineAndCurve(Cursor &cursor)
 {
   CDR_DEBUG_MSG(("CDRParser::readLineAndCurve\n"));
 
-  unsigned short pointNum = readU16(input);
+  unsigned short pointNum = cursor.readU16();
   const unsigned short pointSize = 2 * (m_precision == PRECISION_16BIT ? 2 : 4) + 1;
-  input->seek(2, librevenge::RVNG_SEEK_CUR);
-  if (pointNum > getRemainingLength(input) / pointSize)
-    pointNum = getRemainingLength(input) / pointSize;
+  cursor.skip(2);
+  if (pointNum > cursor.getRemainingLength() / pointSize)
+    pointNum = cursor.getRemainingLength() / pointSize;
   std::vector<std::pair<double, double> > points;
   std::vector<unsigned char> pointTypes;
   points.reserve(pointNum);
   pointTypes.reserve(pointNum);
-  for (unsigned j=0; j<pointNum; j++)
-  {
-    std::pair<double, double> point;
-    point.first = (double)readCoordinate(input);
-    point.second = (double)readCoordinate(input);
-    points.push_back(point);
-  }
-  for (unsigned k=0; k<pointNum; k++)
-    pointTypes.push_back(readU8(input));
+  cursor.readCoordinatePairs(pointNum, points);
+  cursor.readU8Array(pointNum, pointTypes);
+  if (cursor.hasFailed())
+    return;
   outputPath(points, pointTypes);
 }
 
-void libcdr::CDRParser::readPath(librevenge::RVNGInputStream *input)
+template<class Cursor>
+void libcdr::CDRParser::readPath(Cursor &cursor)
 {
   CDR_DEBUG_MSG(("CDRParser::readPath\n"));
 
-  input->seek(4, librevenge::RVNG_SEEK_CUR);
-  unsigned short pointNum = readU16(input)+readU16(input);
+  cursor.skip(4);
+  unsigned short pointNum = cursor.readU16()+cursor.readU16();
   const unsigned short pointSize = 2 * (m_precision == PRECISION_16BIT ? 2 : 4) + 1;
-  const unsigned long maxLength = getRemainingLength(input);
+  const unsigned long maxLength = cursor.getRemainingLength();
   if (maxLength < 16)
     pointNum = 0;
   else if (pointNum > (maxLength - 16) / pointSize)
     pointNum = (maxLength - 16) / pointSize;
-  input->seek(16, librevenge::RVNG_SEEK_CUR);
+  cursor.skip(16);
   std::vector<std::pair<double, double> > points;
   std::vector<unsigned char> pointTypes;
   points.reserve(pointNum);
   pointTypes.reserve(pointNum);
-  for (unsigned j=0; j<pointNum; j++)
-  {
-    std::pair<double, double> point;
-    point.first = (double)readCoordinate(input);
-    point.second = (double)readCoordinate(input);
-    points.push_back(point);
-  }
-  for (unsigned k=0; k<pointNum; k++)
-    pointTypes.push_back(readU8(input));
+  cursor.readCoordinatePairs(pointNum, points);
+  cursor.readU8Array(pointNum, pointTypes);
+  if (cursor.hasFailed())
+    return;
   outputPath(points, pointTypes);
 }
 
@@ -1087,18 +1364,10 @@ void libcdr::CDRParser::readArrw(librevenge::RVNGInputStream *input, unsigned le
   input->seek(4, librevenge::RVNG_SEEK_CUR);
   std::vector<unsigned char> pointTypes;
   pointTypes.reserve(pointSize);
-  for (unsigned k=0; k<pointNum; k++)
-    pointTypes.push_back(readU8(input));
+  readU8Array(input, pointNum, pointTypes);
   input->seek(1, librevenge::RVNG_SEEK_CUR);
   std::vector<std::pair<double, double> > points;
-  points.reserve(pointSize);
-  for (unsigned j=0; j<pointNum; j++)
-  {
-    std::pair<double, double> point;
-    point.second = (double)readCoordinate(input);
-    point.first = (double)readCoordinate(input);
-    points.push_back(point);
-  }
+  readCoordinatePairs(input, pointNum, points, false, true);
   CDRPath path;
   processPath(points, pointTypes, path);
   m_arrows[arrowId] = path;
@@ -1158,15 +1427,8 @@ void libcdr::CDRParser::readBitmap(librevenge::RVNGInputStream *input)
     std::vector<unsigned char> pointTypes;
     points.reserve(pointNum);
     pointTypes.reserve(pointNum);
-    for (unsigned j=0; j<pointNum; j++)
-    {
-      std::pair<double, double> point;
-      point.first = (double)readCoordinate(input);
-      point.second = (double)readCoordinate(input);
-      points.push_back(point);
-    }
-    for (unsigned k=0; k<pointNum; k++)
-      pointTypes.push_back(readU8(input));
+    readCoordinatePairs(input, pointNum, points);
+    readU8Array(input, pointNum, pointTypes);
     outputPath(points, pointTypes);
   }
   m_collector->collectBitmap(imageId, x1, x2, y1, y2);
@@ -1299,36 +1561,34 @@ void libcdr::CDRParser::readWaldoFill(librevenge::RVNGInputStream *input)
   m_collector->collectFillStyleId(m_waldoFillId);
 }
 
-void libcdr::CDRParser::readTrfd(librevenge::RVNGInputStream *input, unsigned length)
+template<class Cursor>
+void libcdr::CDRParser::readTrfd(Cursor &cursor, unsigned length)
 {
-  if (!_redirectX6Chunk(&input, length))
-    throw GenericException();
-  long startPosition = input->tell();
-  const unsigned long maxLength = getLength(input);
-  if (startPosition >= long(maxLength))
+  const unsigned long maxLength = cursor.getRemainingLength();
+  if (!maxLength)
     return;
-  if ((length > maxLength) || (long(maxLength - length) < startPosition))
-    length = unsigned(maxLength - static_cast<unsigned long>(startPosition)); // sanitize length
-  unsigned chunkLength = readUnsigned(input);
-  unsigned numOfArgs = readUnsigned(input);
-  unsigned startOfArgs = readUnsigned(input);
+  if (length > maxLength)
+    length = unsigned(maxLength); // sanitize length
+  unsigned chunkLength = cursor.readUnsigned();
+  unsigned numOfArgs = cursor.readUnsigned();
+  unsigned startOfArgs = cursor.readUnsigned();
   if (startOfArgs >= length)
     return;
   if (numOfArgs > (length - startOfArgs) / 4) // avoid extra big allocation in case of a broken file
     numOfArgs = (length - startOfArgs) / 4;
   std::vector<unsigned> argOffsets(numOfArgs, 0);
   size_t i = 0;
-  input->seek(startPosition+startOfArgs, librevenge::RVNG_SEEK_SET);
+  cursor.seek(startOfArgs);
   while (i<numOfArgs)
-    argOffsets[i++] = readUnsigned(input);
+    argOffsets[i++] = cursor.readUnsigned();
 
   CDRTransforms trafos;
   for (i=0; i < argOffsets.size(); i++)
   {
-    input->seek(startPosition+argOffsets[i], librevenge::RVNG_SEEK_SET);
+    cursor.seek(argOffsets[i]);
     if (m_version >= 1300)
-      input->seek(8, librevenge::RVNG_SEEK_CUR);
-    unsigned short tmpType = readU16(input);
+      cursor.skip(8);
+    unsigned short tmpType = cursor.readU16();
     if (tmpType == 0x08) // trafo
     {
       double v0 = 0.0;
@@ -1338,35 +1598,35 @@ void libcdr::CDRParser::readTrfd(librevenge::RVNGInputStream *input, unsigned le
       double v4 = 0.0;
       double y0 = 0.0;
       if (m_version >= 600)
-        input->seek(6, librevenge::RVNG_SEEK_CUR);
+        cursor.skip(6);
       if (m_version >= 500)
       {
-        v0 = readDouble(input);
-        v1 = readDouble(input);
-        x0 = readDouble(input) / (m_version < 600 ? 1000.0 : 254000.0);
-        v3 = readDouble(input);
-        v4 = readDouble(input);
-        y0 = readDouble(input) / (m_version < 600 ? 1000.0 : 254000.0);
+        v0 = cursor.readDouble();
+        v1 = cursor.readDouble();
+        x0 = cursor.readDouble() / (m_version < 600 ? 1000.0 : 254000.0);
+        v3 = cursor.readDouble();
+        v4 = cursor.readDouble();
+        y0 = cursor.readDouble() / (m_version < 600 ? 1000.0 : 254000.0);
       }
       else
       {
-        v0 = readFixedPoint(input);
-        v1 = readFixedPoint(input);
-        x0 = (double)readS32(input) / 1000.0;
-        v3 = readFixedPoint(input);
-        v4 = readFixedPoint(input);
-        y0 = (double)readS32(input) / 1000.0;
+        v0 = cursor.readFixedPoint();
+        v1 = cursor.readFixedPoint();
+        x0 = (double)cursor.readS32() / 1000.0;
+        v3 = cursor.readFixedPoint();
+        v4 = cursor.readFixedPoint();
+        y0 = (double)cursor.readS32() / 1000.0;
       }
       trafos.append(v0, v1, x0, v3, v4, y0);
     }
     else if (tmpType == 0x10)
     {
 #if 0
-      input->seek(6, librevenge::RVNG_SEEK_CUR);
-      unsigned short type = readU16(input);
-      double x = readCoordinate(input);
-      double y = readCoordinate(input);
-      unsigned subType = readU32(input);
+      cursor.skip(6);
+      unsigned short type = cursor.readU16();
+      double x = cursor.readCoordinate();
+      double y = cursor.readCoordinate();
+      unsigned subType = cursor.readU32();
       if (!subType)
       {
       }
@@ -1382,14 +1642,14 @@ void libcdr::CDRParser::readTrfd(librevenge::RVNGInputStream *input, unsigned le
         {
         }
       }
-      unsigned opt1 = readU32(input);
-      unsigned opt2 = readU32(input);
+      unsigned opt1 = cursor.readU32();
+      unsigned opt2 = cursor.readU32();
 #endif
     }
   }
-  if (!trafos.empty())
+  if (!trafos.empty() && !cursor.hasFailed())
     m_collector->collectTransform(trafos,m_version < 400);
-  input->seek(startPosition+chunkLength, librevenge::RVNG_SEEK_SET);
+  cursor.seek(chunkLength);
 }
 
 void libcdr::CDRParser::readFild(librevenge::RVNGInputStream *input, unsigned length)
@@ -1707,68 +1967,76 @@ void libcdr::CDRParser::readOutl(librevenge::RVNGInputStream *input, unsigned le
   m_collector->collectLineStyle(lineId, CDRLineStyle(lineType, capsType, joinType, lineWidth, stretch, angle, color, dashArray, startMarker, endMarker));
 }
 
-void libcdr::CDRParser::readLoda(librevenge::RVNGInputStream *input, unsigned length)
+template<class Cursor>
+void libcdr::CDRParser::readLoda(Cursor &cursor, librevenge::RVNGInputStream *input, unsigned length)
 {
-  if (!_redirectX6Chunk(&input, length))
-    throw GenericException();
-  long startPosition = input->tell();
-  const unsigned long maxLength = getLength(input);
-  if (startPosition >= long(maxLength))
+  const long startPosition = input->tell();
+  const unsigned long maxLength = cursor.getRemainingLength();
+  if (!maxLength)
     return;
-  if ((length > maxLength) || (long(maxLength - length) < startPosition))
-    length = unsigned(maxLength - static_cast<unsigned long>(startPosition)); // sanitize length
-  unsigned chunkLength = readUnsigned(input);
-  unsigned numOfArgs = readUnsigned(input);
-  unsigned startOfArgs = readUnsigned(input);
+  if (length > maxLength)
+    length = unsigned(maxLength); // sanitize length
+  unsigned chunkLength = cursor.readUnsigned();
+  unsigned numOfArgs = cursor.readUnsigned();
+  unsigned startOfArgs = cursor.readUnsigned();
   if (startOfArgs >= length)
     return;
-  unsigned startOfArgTypes = readUnsigned(input);
+  unsigned startOfArgTypes = cursor.readUnsigned();
   if (startOfArgTypes >= length)
     return;
   if (numOfArgs > (length - startOfArgs) / 4) // avoid extra big allocation in case of a broken file
     numOfArgs = (length - startOfArgs) / 4;
-  unsigned chunkType = readUnsigned(input);
+  unsigned chunkType = cursor.readUnsigned();
+  if (cursor.hasFailed())
+    return;
   if (chunkType == 0x26)
     m_collector->collectSpline();
   std::vector<unsigned> argOffsets(numOfArgs, 0);
   std::vector<unsigned> argTypes(numOfArgs, 0);
   size_t i = 0;
-  input->seek(startPosition+startOfArgs, librevenge::RVNG_SEEK_SET);
+  cursor.seek(startOfArgs);
   while (i<numOfArgs)
-    argOffsets[i++] = readUnsigned(input);
-  input->seek(startPosition+startOfArgTypes, librevenge::RVNG_SEEK_SET);
+    argOffsets[i++] = cursor.readUnsigned();
+  cursor.seek(startOfArgTypes);
   while (i>0)
-    argTypes[--i] = readUnsigned(input);
+    argTypes[--i] = cursor.readUnsigned();
 
-  for (i=0; i < argTypes.size(); i++)
+  // the readers without a cursor read the argument from input
+  auto inputAt = [input, startPosition](unsigned offset)
   {
-    input->seek(startPosition+argOffsets[i], librevenge::RVNG_SEEK_SET);
+    input->seek(startPosition + long(offset), librevenge::RVNG_SEEK_SET);
+    return input;
+  };
+  // a failed read yields 0, which collects no fill, outline or style id
+  for (i=0; i < argTypes.size() && !cursor.hasFailed(); i++)
+  {
+    cursor.seek(argOffsets[i]);
     if (argTypes[i] == 0x1e) // loda coords
     {
       if ((m_version >= 400 && chunkType == 0x01) || (m_version < 400 && chunkType == 0x00)) // Rectangle
-        readRectangle(input);
+        readRectangle(cursor);
       else if ((m_version >= 400 && chunkType == 0x02) || (m_version < 400 && chunkType == 0x01)) // Ellipse
-        readEllipse(input);
+        readEllipse(cursor);
       else if ((m_version >= 400 && chunkType == 0x03) || (m_version < 400 && chunkType == 0x02)) // Line and curve
-        readLineAndCurve(input);
+        readLineAndCurve(cursor);
       else if (chunkType == 0x25) // Path
-        readPath(input);
+        readPath(cursor);
       else if ((m_version >= 400 && chunkType == 0x04) || (m_version < 400 && chunkType == 0x03)) // Artistic text
-        readArtisticText(input);
+        readArtisticText(inputAt(argOffsets[i]));
       else if ((m_version >= 400 && chunkType == 0x05) || (m_version < 400 && chunkType == 0x04)) // Bitmap
-        readBitmap(input);
+        readBitmap(inputAt(argOffsets[i]));
       else if ((m_version >= 400 && chunkType == 0x06) || (m_version < 400 && chunkType == 0x05)) // Paragraph text
-        readParagraphText(input);
+        readParagraphText(inputAt(argOffsets[i]));
       else if (chunkType == 0x14) // Polygon
-        readPolygonCoords(input);
+        readPolygonCoords(cursor);
     }
     else if (argTypes[i] == 0x14)
     {
       if (m_version < 400)
-        readWaldoFill(input);
+        readWaldoFill(inputAt(argOffsets[i]));
       else
       {
-        unsigned fillId = readU32(input);
+        unsigned fillId = cursor.readU32();
         if (fillId)
           m_collector->collectFillStyleId(fillId);
       }
@@ -1776,33 +2044,33 @@ void libcdr::CDRParser::readLoda(librevenge::RVNGInputStream *input, unsigned le
     else if (argTypes[i] == 0x0a)
     {
       if (m_version < 400)
-        readWaldoOutl(input);
+        readWaldoOutl(inputAt(argOffsets[i]));
       else
       {
-        unsigned outlId = readU32(input);
+        unsigned outlId = cursor.readU32();
         if (outlId)
           m_collector->collectLineStyleId(outlId);
       }
     }
     else if (argTypes[i] == 0xc8)
     {
-      unsigned styleId = readUnsigned(input);
+      unsigned styleId = cursor.readUnsigned();
       if (styleId)
         m_collector->collectStyleId(styleId);
     }
     else if (argTypes[i] == 0x2af8)
-      readPolygonTransform(input);
+      readPolygonTransform(cursor);
     else if (argTypes[i] == 0x1f40)
-      readOpacity(input, length);
+      readOpacity(cursor);
     else if (argTypes[i] == 0x64)
     {
       if (m_version < 400)
-        readWaldoTrfd(input);
+        readWaldoTrfd(inputAt(argOffsets[i]));
     }
     else if (argTypes[i] == 0x4aba)
-      readPageSize(input);
+      readPageSize(cursor);
   }
-  input->seek(startPosition+chunkLength, librevenge::RVNG_SEEK_SET);
+  cursor.seek(chunkLength);
 }
 
 void libcdr::CDRParser::readFlags(librevenge::RVNGInputStream *input, unsigned length)
@@ -1811,6 +2079,8 @@ void libcdr::CDRParser::readFlags(librevenge::RVNGInputStream *input, unsigned l
     throw GenericException();
   unsigned flags = readU32(input);
   m_collector->collectFlags(flags, m_version >= 400);
+  if (m_tape)
+    m_tape->addFlags(flags, m_version >= 400);
 }
 
 void libcdr::CDRParser::readMcfg(librevenge::RVNGInputStream *input, unsigned length)
@@ -1843,55 +2113,57 @@ void libcdr::CDRParser::readMcfg(librevenge::RVNGInputStream *input, unsigned le
   m_collector->collectPageSize(width, height, -width/2.0, -height/2.0);
 }
 
-void libcdr::CDRParser::readPolygonCoords(librevenge::RVNGInputStream *input)
+template<class Cursor>
+void libcdr::CDRParser::readPolygonCoords(Cursor &cursor)
 {
   CDR_DEBUG_MSG(("CDRParser::readPolygonCoords\n"));
 
-  unsigned short pointNum = readU16(input);
+  unsigned short pointNum = cursor.readU16();
   const unsigned short pointSize = 2 * (m_precision == PRECISION_16BIT ? 2 : 4) + 1;
-  if (pointNum > getRemainingLength(input) / pointSize)
-    pointNum = getRemainingLength(input) / pointSize;
-  input->seek(2, librevenge::RVNG_SEEK_CUR);
+  if (pointNum > cursor.getRemainingLength() / pointSize)
+    pointNum = cursor.getRemainingLength() / pointSize;
+  cursor.skip(2);
   std::vector<std::pair<double, double> > points;
   std::vector<unsigned char> pointTypes;
   points.reserve(pointNum);
   pointTypes.reserve(pointNum);
-  for (unsigned j=0; j<pointNum; j++)
-  {
-    std::pair<double, double> point;
-    point.first = (double)readCoordinate(input);
-    point.second = (double)readCoordinate(input);
-    points.push_back(point);
-  }
-  for (unsigned k=0; k<pointNum; k++)
-    pointTypes.push_back(readU8(input));
+  cursor.readCoordinatePairs(pointNum, points);
+  cursor.readU8Array(pointNum, pointTypes);
+  if (cursor.hasFailed())
+    return;
   outputPath(points, pointTypes);
   m_collector->collectPolygon();
 }
 
-void libcdr::CDRParser::readPolygonTransform(librevenge::RVNGInputStream *input)
+template<class Cursor>
+void libcdr::CDRParser::readPolygonTransform(Cursor &cursor)
 {
   if (m_version < 1300)
-    input->seek(4, librevenge::RVNG_SEEK_CUR);
-  unsigned numAngles = readU32(input);
-  unsigned nextPoint = readU32(input);
+    cursor.skip(4);
+  unsigned numAngles = cursor.readU32();
+  unsigned nextPoint = cursor.readU32();
   if (nextPoint <= 1)
-    nextPoint = readU32(input);
+    nextPoint = cursor.readU32();
   else
-    input->seek(4, librevenge::RVNG_SEEK_CUR);
+    cursor.skip(4);
   if (m_version >= 1300)
-    input->seek(4, librevenge::RVNG_SEEK_CUR);
-  double rx = readDouble(input);
-  double ry = readDouble(input);
-  double cx = readCoordinate(input);
-  double cy = readCoordinate(input);
+    cursor.skip(4);
+  double rx = cursor.readDouble();
+  double ry = cursor.readDouble();
+  double cx = cursor.readCoordinate();
+  double cy = cursor.readCoordinate();
+  if (cursor.hasFailed())
+    return;
   m_collector->collectPolygonTransform(numAngles, nextPoint, rx, ry, cx, cy);
 }
 
-void libcdr::CDRParser::readPageSize(librevenge::RVNGInputStream *input)
+template<class Cursor>
+void libcdr::CDRParser::readPageSize(Cursor &cursor)
 {
-  double width = readCoordinate(input);
-  double height = readCoordinate(input);
+  double width = cursor.readCoordinate();
+  double height = cursor.readCoordinate();
+  if (cursor.hasFailed())
+    return;
   m_collector->collectPageSize(width, height, -width/2.0, -height/2.0);
 }
 
@@ -1943,19 +2215,22 @@ void libcdr::CDRParser::readBmp(librevenge::RVNGInputStream *input, unsigned len
     input->seek(46, librevenge::RVNG_SEEK_CUR);
   else
     input->seek(50, librevenge::RVNG_SEEK_CUR);
-  unsigned colorModel, width, height, bpp;
-  std::vector<unsigned> palette;
-  readRImage(colorModel, width, height, bpp, palette, bitmap, input);
-  m_collector->collectBmp(imageId, colorModel, width, height, bpp, palette, bitmap);
+  CDRBitmap rImage;
+  readRImage(rImage.colorModel, rImage.width, rImage.height, rImage.bpp, rImage.palette, rImage.bitmap,
+             rImage.bitmapSize, input);
+  m_collector->collectBmp(imageId, rImage);
 }
 
-void libcdr::CDRParser::readOpacity(librevenge::RVNGInputStream *input, unsigned /* length */)
+template<class Cursor>
+void libcdr::CDRParser::readOpacity(Cursor &cursor)
 {
   if (m_version < 1300)
-    input->seek(10, librevenge::RVNG_SEEK_CUR);
+    cursor.skip(10);
   else
-    input->seek(14, librevenge::RVNG_SEEK_CUR);
-  double opacity = (double)readU16(input) / 1000.0;
+    cursor.skip(14);
+  double opacity = (double)cursor.readU16() / 1000.0;
+  if (cursor.hasFailed())
+    return;
   m_collector->collectFillOpacity(opacity);
 }
 
@@ -2006,13 +2281,7 @@ void libcdr::CDRParser::readPpdt(librevenge::RVNGInputStream *input, unsigned le
   std::vector<unsigned> knotVector;
   points.reserve(pointNum);
   knotVector.reserve(pointNum);
-  for (unsigned j=0; j<pointNum; j++)
-  {
-    std::pair<double, double> point;
-    point.first = (double)readCoordinate(input);
-    point.second = (double)readCoordinate(input);
-    points.push_back(point);
-  }
+  readCoordinatePairs(input, pointNum, points);
   for (unsigned k=0; k<pointNum; k++)
     knotVector.push_back(readU32(input));
   m_collector->collectPpdt(points, knotVector);
@@ -2084,14 +2353,15 @@ void libcdr::CDRParser::readIccd(librevenge::RVNGInputStream *input, unsigned le
   m_collector->collectColorProfile(profile);
 }
 
-void libcdr::CDRParser::readBBox(librevenge::RVNGInputStream *input, unsigned length)
+template<class Cursor>
+void libcdr::CDRParser::readBBox(Cursor &cursor)
 {
-  if (!_redirectX6Chunk(&input, length))
-    throw GenericException();
-  double x0 = readCoordinate(input);
-  double y0 = readCoordinate(input);
-  double x1 = readCoordinate(input);
-  double y1 = readCoordinate(input);
+  double x0 = cursor.readCoordinate();
+  double y0 = cursor.readCoordinate();
+  double x1 = cursor.readCoordinate();
+  double y1 = cursor.readCoordinate();
+  if (cursor.hasFailed())
+    return;
   m_collector->collectBBox(x0, y0, x1, y1);
 }
 
@@ -2151,7 +2421,8 @@ void libcdr::CDRParser::readFont(librevenge::RVNGInputStream *input, unsigned le
       else
         break;
     }
-    appendCharacters(fontName, name);
+    if (m_options.analyseText)
+      appendCharacters(fontName, name);
   }
   else
   {
@@ -2164,7 +2435,8 @@ void libcdr::CDRParser::readFont(librevenge::RVNGInputStream *input, unsigned le
       else
         break;
     }
-    appendCharacters(fontName, name, fontEncoding);
+    if (m_options.analyseText)
+      appendCharacters(fontName, name, fontEncoding);
   }
   if (!fontEncoding)
     processNameForEncoding(fontName, fontEncoding);
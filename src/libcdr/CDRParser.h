@@ -15,6 +15,7 @@
 #include <map>
 #include <stack>
 #include <librevenge-stream/librevenge-stream.h>
+#include <libcdr/CDRParseOptions.h>
 #include "CDRTypes.h"
 #include "CommonParser.h"
 
@@ -22,6 +23,8 @@ namespace libcdr
 {
 
 class CDRCollector;
+class CDRInflatePipeline;
+class CDRRecordTape;
 
 class CDRParser : protected CommonParser
 {
@@ -30,6 +33,25 @@ public:
   ~CDRParser() override;
   bool parseRecords(librevenge::RVNGInputStream *input, const std::vector<unsigned> &blockLengths = std::vector<unsigned>(), unsigned level = 0);
   bool parseWaldo(librevenge::RVNGInputStream *input);
+  /* Makes parseRecords record the records it meets into tape. With
+     structureOnly, the records are only recorded and not read, which
+     is enough to index the pages */
+  void setRecordTape(CDRRecordTape *tape, bool structureOnly = false);
+  /* Makes parseRecords take the cmpr lists from pipeline, which
+     inflates them ahead from the input passed to parseRecords */
+  void setInflatePipeline(CDRInflatePipeline *pipeline);
+  /* Turns off the reading of what the options leave out */
+  void setParseOptions(const CDRParseOptions &options);
+  /* Makes the parser skip the records which only feed the styles pass,
+     like the bitmaps, the color profiles and the texts, for a content
+     pass following it */
+  void setSkipStylesRecords(bool skip);
+  using CommonParser::setParseTracker;
+  /* Goes through the records of tape, recorded by a previous parse of
+     input, instead of parsing input again. The page lists outside of
+     firstPage to lastPage are skipped */
+  bool replayRecords(librevenge::RVNGInputStream *input, const CDRRecordTape &tape,
+                     unsigned firstPage = 0, unsigned lastPage = (unsigned)-1);
 
 private:
   CDRParser();
@@ -44,32 +66,54 @@ private:
                               std::map<unsigned, WaldoRecordInfo> &records8, std::map<unsigned, WaldoRecordInfo> recordsOther);
   void readWaldoRecord(librevenge::RVNGInputStream *input, const WaldoRecordInfo &info);
   bool parseRecord(librevenge::RVNGInputStream *input, const std::vector<unsigned> &blockLengths = std::vector<unsigned>(), unsigned level = 0);
-  void readRecord(unsigned fourCC, unsigned length, librevenge::RVNGInputStream *input);
-  double readRectCoord(librevenge::RVNGInputStream *input);
+  /* The offset in the document of the current position of input, for
+     the progress; -1 if it is not known */
+  long getInputPosition(librevenge::RVNGInputStream *input) const;
+  /* Returns false if the record is broken, which stops the parsing */
+  bool readRecord(unsigned fourCC, unsigned length, librevenge::RVNGInputStream *input);
+  /* Reads the records which have a reader taking a cursor, with a
+     memory cursor if input keeps its data in memory. Returns false if
+     the cursor failed */
+  bool readRecordWithCursor(unsigned fourCC, unsigned length, librevenge::RVNGInputStream *input);
+  template<class Cursor>
+  bool readCursorRecord(unsigned fourCC, unsigned length, Cursor &cursor, librevenge::RVNGInputStream *input);
+  void collectListType(unsigned listType, unsigned level);
+  template<class Cursor>
+  double readRectCoord(Cursor &cursor);
   CDRColor readColor(librevenge::RVNGInputStream *input);
 
-  void readRectangle(librevenge::RVNGInputStream *input);
-  void readEllipse(librevenge::RVNGInputStream *input);
-  void readLineAndCurve(librevenge::RVNGInputStream *input);
+  template<class Cursor>
+  void readRectangle(Cursor &cursor);
+  template<class Cursor>
+  void readEllipse(Cursor &cursor);
+  template<class Cursor>
+  void readLineAndCurve(Cursor &cursor);
   void readBitmap(librevenge::RVNGInputStream *input);
-  void readPageSize(librevenge::RVNGInputStream *input);
+  template<class Cursor>
+  void readPageSize(Cursor &cursor);
   void readWaldoBmp(librevenge::RVNGInputStream *input, unsigned length, unsigned id);
   void readWaldoBmpf(librevenge::RVNGInputStream *input, unsigned id);
   void readWaldoTrfd(librevenge::RVNGInputStream *input);
   void readWaldoOutl(librevenge::RVNGInputStream *input);
   void readWaldoFill(librevenge::RVNGInputStream *input);
   void readWaldoLoda(librevenge::RVNGInputStream *input, unsigned length);
-  void readOpacity(librevenge::RVNGInputStream *input, unsigned length);
-  void readTrfd(librevenge::RVNGInputStream *input, unsigned length);
+  template<class Cursor>
+  void readOpacity(Cursor &cursor);
+  template<class Cursor>
+  void readTrfd(Cursor &cursor, unsigned length);
   void readFild(librevenge::RVNGInputStream *input, unsigned length);
   void readOutl(librevenge::RVNGInputStream *input, unsigned length);
-  void readLoda(librevenge::RVNGInputStream *input, unsigned length);
+  template<class Cursor>
+  void readLoda(Cursor &cursor, librevenge::RVNGInputStream *input, unsigned length);
   void readFlags(librevenge::RVNGInputStream *input, unsigned length);
   void readMcfg(librevenge::RVNGInputStream *input, unsigned length);
-  void readPath(librevenge::RVNGInputStream *input);
+  template<class Cursor>
+  void readPath(Cursor &cursor);
   void readArrw(librevenge::RVNGInputStream *input, unsigned length);
-  void readPolygonCoords(librevenge::RVNGInputStream *input);
-  void readPolygonTransform(librevenge::RVNGInputStream *input);
+  template<class Cursor>
+  void readPolygonCoords(Cursor &cursor);
+  template<class Cursor>
+  void readPolygonTransform(Cursor &cursor);
   void readBmp(librevenge::RVNGInputStream *input, unsigned length);
   void readBmpf(librevenge::RVNGInputStream *input, unsigned length);
   void readPpdt(librevenge::RVNGInputStream *input, unsigned length);
@@ -77,7 +121,8 @@ private:
   void readDisp(librevenge::RVNGInputStream *input, unsigned length);
   void readVersion(librevenge::RVNGInputStream *input, unsigned length);
   void readIccd(librevenge::RVNGInputStream *input, unsigned length);
-  void readBBox(librevenge::RVNGInputStream *input, unsigned length);
+  template<class Cursor>
+  void readBBox(Cursor &cursor);
   void readSpnd(librevenge::RVNGInputStream *input, unsigned length);
   void readVpat(librevenge::RVNGInputStream *input, unsigned length);
   void readUidr(librevenge::RVNGInputStream *input, unsigned length);
@@ -108,6 +153,23 @@ private:
   unsigned m_waldoOutlId;
   unsigned m_waldoFillId;
 
+  CDRRecordTape *m_tape;
+  unsigned m_tapeStream;
+  bool m_structureOnly;
+  bool m_skipStylesRecords;
+  CDRInflatePipeline *m_inflatePipeline;
+  CDRParseOptions m_options;
+  /* Offset in the input of the stream being parsed, or -1 if it is not
+     a part of the input. Inside a cmpr list, it is the offset in the
+     inflated data of the list instead */
+  long m_inputOffset;
+  /* The offset in the input of the cmpr list being parsed, or -1 */
+  long m_cmprInputOffset;
+  /* The compressed and the inflated sizes of that list; the inflated
+     size is 0 if the positions inside it are not known */
+  unsigned long m_cmprInputLength;
+  unsigned long m_cmprLength;
+
 };
 
 } // namespace libcdr
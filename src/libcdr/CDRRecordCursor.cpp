@@ -0,0 +1,29 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libcdr project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "CDRRecordCursor.h"
+
+#include "CDRInternalStream.h"
+
+bool libcdr::getMemorySpan(librevenge::RVNGInputStream *input, const unsigned char *&data, unsigned long &size)
+{
+  data = nullptr;
+  size = 0;
+  const auto *internalStream = dynamic_cast<const CDRInternalStream *>(input);
+  if (!internalStream || !internalStream->getBuffer())
+    return false;
+  const long position = input->tell();
+  if (position < 0 || static_cast<unsigned long>(position) > internalStream->getSize())
+    return false;
+  data = internalStream->getBuffer().get() + position;
+  size = internalStream->getSize() - static_cast<unsigned long>(position);
+  return true;
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,398 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libcdr project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef __CDRRECORDCURSOR_H__
+#define __CDRRECORDCURSOR_H__
+
+#include <math.h>
+#include <string.h>
+#include <utility>
+#include <vector>
+
+#include <librevenge-stream/librevenge-stream.h>
+#include "CommonParser.h"
+#include "libcdr_utils.h"
+
+namespace libcdr
+{
+
+namespace detail
+{
+
+template<bool BigEndian>
+inline uint16_t getU16(const unsigned char *p)
+{
+  return BigEndian ? uint16_t(p[1] | (p[0] << 8)) : uint16_t(p[0] | (p[1] << 8));
+}
+
+template<bool BigEndian>
+inline uint32_t getU32(const unsigned char *p)
+{
+  return BigEndian
+         ? (uint32_t)p[3] | ((uint32_t)p[2] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[0] << 24)
+         : (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+template<bool BigEndian>
+inline uint64_t getU64(const unsigned char *p)
+{
+  return BigEndian
+         ? (uint64_t)getU32<true>(p + 4) | ((uint64_t)getU32<true>(p) << 32)
+         : (uint64_t)getU32<false>(p) | ((uint64_t)getU32<false>(p + 4) << 32);
+}
+
+template<bool BigEndian, CoordinatePrecision Precision>
+struct CoordinateDecoder;
+
+template<bool BigEndian>
+struct CoordinateDecoder<BigEndian, PRECISION_16BIT>
+{
+  static const unsigned long SIZE = 2;
+  static double coordinate(const unsigned char *p)
+  {
+    return (double)(int16_t)getU16<BigEndian>(p) / 1000.0;
+  }
+  static double angle(const unsigned char *p)
+  {
+    return M_PI * (double)(int16_t)getU16<BigEndian>(p) / 1800.0;
+  }
+};
+
+template<bool BigEndian>
+struct CoordinateDecoder<BigEndian, PRECISION_32BIT>
+{
+  static const unsigned long SIZE = 4;
+  static double coordinate(const unsigned char *p)
+  {
+    return (double)(int32_t)getU32<BigEndian>(p) / 254000.0;
+  }
+  static double angle(const unsigned char *p)
+  {
+    return M_PI * (double)(int32_t)getU32<BigEndian>(p) / 180000000.0;
+  }
+};
+
+template<bool BigEndian, CoordinatePrecision Precision>
+void decodeCoordinatePairs(const unsigned char *p, unsigned pointNum, std::vector<std::pair<double, double> > &points, bool swap)
+{
+  typedef CoordinateDecoder<BigEndian, Precision> Decoder;
+  points.reserve(points.size() + pointNum);
+  for (unsigned j = 0; j < pointNum; j++, p += 2 * Decoder::SIZE)
+  {
+    const double first = Decoder::coordinate(p);
+    const double second = Decoder::coordinate(p + Decoder::SIZE);
+    points.push_back(swap ? std::make_pair(second, first) : std::make_pair(first, second));
+  }
+}
+
+} // namespace detail
+
+/* Reads a record from memory, without any virtual call.
+
+   The cursor starts at the beginning of the record and reaches up to
+   the end of the data holding it, so a broken record length reads the
+   same bytes as a stream would. The data are bounded once, when the
+   cursor is created; every read then only compares two pointers.
+
+   A read going past the end does not throw: it sets a fail bit and
+   returns 0, and so does every read after it. The readers check the
+   bit before passing what they read on, and the record is dropped if
+   it is set once the record has been read. Positions are relative to
+   the start of the record. */
+template<bool BigEndian, CoordinatePrecision Precision>
+class CDRRecordCursor
+{
+  typedef detail::CoordinateDecoder<BigEndian, Precision> Decoder;
+
+public:
+  CDRRecordCursor(const unsigned char *data, unsigned long size)
+    : m_begin(data), m_end(data + size), m_pos(data), m_failed(false) {}
+
+  bool hasFailed() const
+  {
+    return m_failed;
+  }
+  unsigned long tell() const
+  {
+    return (unsigned long)(m_pos - m_begin);
+  }
+  /* Moves to offset, clamped to the data like CDRInternalStream::seek */
+  void seek(unsigned long offset)
+  {
+    m_pos = offset < (unsigned long)(m_end - m_begin) ? m_begin + offset : m_end;
+  }
+  void skip(unsigned long numBytes)
+  {
+    seek(tell() + numBytes);
+  }
+  unsigned long getRemainingLength() const
+  {
+    return (unsigned long)(m_end - m_pos);
+  }
+  bool isEnd() const
+  {
+    return m_pos >= m_end;
+  }
+
+  uint8_t readU8()
+  {
+    return *take(1);
+  }
+  uint16_t readU16()
+  {
+    return detail::getU16<BigEndian>(take(2));
+  }
+  int16_t readS16()
+  {
+    return (int16_t)readU16();
+  }
+  uint32_t readU32()
+  {
+    return detail::getU32<BigEndian>(take(4));
+  }
+  int32_t readS32()
+  {
+    return (int32_t)readU32();
+  }
+  uint64_t readU64()
+  {
+    return detail::getU64<BigEndian>(take(8));
+  }
+  double readDouble()
+  {
+    const uint64_t value = readU64();
+    double result;
+    memcpy(&result, &value, sizeof(result));
+    return result;
+  }
+  double readFixedPoint()
+  {
+    const unsigned value = readU32();
+    return (double)(short)((value & 0xFFFF0000) >> 16) + (double)(value & 0x0000FFFF) / (double)0xFFFF;
+  }
+  void readU8Array(unsigned long count, std::vector<unsigned char> &values)
+  {
+    if (!canTake(count))
+      return;
+    values.insert(values.end(), m_pos, m_pos + count);
+    m_pos += count;
+  }
+
+  double readCoordinate()
+  {
+    return Decoder::coordinate(take(Decoder::SIZE));
+  }
+  unsigned readUnsigned()
+  {
+    return Precision == PRECISION_16BIT ? (unsigned)readU16() : readU32();
+  }
+  unsigned short readUnsignedShort()
+  {
+    return Precision == PRECISION_16BIT ? (unsigned short)readU8() : readU16();
+  }
+  int readInteger()
+  {
+    return Precision == PRECISION_16BIT ? (int)readS16() : readS32();
+  }
+  double readAngle()
+  {
+    return Decoder::angle(take(Decoder::SIZE));
+  }
+  void readCoordinatePairs(unsigned pointNum, std::vector<std::pair<double, double> > &points, bool swap = false)
+  {
+    const unsigned long numBytes = 2 * Decoder::SIZE * (unsigned long)pointNum;
+    if (!canTake(numBytes))
+      return;
+    detail::decodeCoordinatePairs<BigEndian, Precision>(m_pos, pointNum, points, swap);
+    m_pos += numBytes;
+  }
+
+private:
+  bool canTake(unsigned long numBytes)
+  {
+    if (!m_failed && (unsigned long)(m_end - m_pos) >= numBytes)
+      return true;
+    m_pos = m_end;
+    m_failed = true;
+    return false;
+  }
+  /* numBytes is at most 8 */
+  const unsigned char *take(unsigned long numBytes)
+  {
+    static const unsigned char zeros[8] = { 0 };
+    if (!canTake(numBytes))
+      return zeros;
+    const unsigned char *p = m_pos;
+    m_pos += numBytes;
+    return p;
+  }
+
+  const unsigned char *m_begin;
+  const unsigned char *m_end;
+  const unsigned char *m_pos;
+  bool m_failed;
+};
+
+/* The same interface as CDRRecordCursor, reading the record from a
+   stream which does not keep its data in memory */
+template<bool BigEndian, CoordinatePrecision Precision>
+class CDRStreamCursor
+{
+  typedef detail::CoordinateDecoder<BigEndian, Precision> Decoder;
+
+public:
+  explicit CDRStreamCursor(librevenge::RVNGInputStream *input)
+    : m_input(input), m_start(input->tell()), m_failed(false) {}
+
+  bool hasFailed() const
+  {
+    return m_failed;
+  }
+  unsigned long tell() const
+  {
+    return (unsigned long)(m_input->tell() - m_start);
+  }
+  void seek(unsigned long offset)
+  {
+    m_input->seek(m_start + long(offset), librevenge::RVNG_SEEK_SET);
+  }
+  void skip(unsigned long numBytes)
+  {
+    m_input->seek(long(numBytes), librevenge::RVNG_SEEK_CUR);
+  }
+  unsigned long getRemainingLength() const
+  {
+    return libcdr::getRemainingLength(m_input);
+  }
+  bool isEnd() const
+  {
+    return m_input->isEnd();
+  }
+
+  uint8_t readU8()
+  {
+    unsigned char data[1];
+    readBytes(data, 1);
+    return data[0];
+  }
+  uint16_t readU16()
+  {
+    unsigned char data[2];
+    readBytes(data, 2);
+    return detail::getU16<BigEndian>(data);
+  }
+  int16_t readS16()
+  {
+    return (int16_t)readU16();
+  }
+  uint32_t readU32()
+  {
+    unsigned char data[4];
+    readBytes(data, 4);
+    return detail::getU32<BigEndian>(data);
+  }
+  int32_t readS32()
+  {
+    return (int32_t)readU32();
+  }
+  uint64_t readU64()
+  {
+    unsigned char data[8];
+    readBytes(data, 8);
+    return detail::getU64<BigEndian>(data);
+  }
+  double readDouble()
+  {
+    const uint64_t value = readU64();
+    double result;
+    memcpy(&result, &value, sizeof(result));
+    return result;
+  }
+  double readFixedPoint()
+  {
+    const unsigned value = readU32();
+    return (double)(short)((value & 0xFFFF0000) >> 16) + (double)(value & 0x0000FFFF) / (double)0xFFFF;
+  }
+  void readU8Array(unsigned long count, std::vector<unsigned char> &values)
+  {
+    if (m_failed || !count)
+      return;
+    unsigned long numBytes = 0;
+    const unsigned char *p = m_input->peekSpan(count, count, numBytes);
+    if (!p)
+    {
+      m_failed = true;
+      return;
+    }
+    values.insert(values.end(), p, p + count);
+    m_input->seek(long(count), librevenge::RVNG_SEEK_CUR);
+  }
+
+  double readCoordinate()
+  {
+    unsigned char data[Decoder::SIZE];
+    readBytes(data, Decoder::SIZE);
+    return Decoder::coordinate(data);
+  }
+  unsigned readUnsigned()
+  {
+    return Precision == PRECISION_16BIT ? (unsigned)readU16() : readU32();
+  }
+  unsigned short readUnsignedShort()
+  {
+    return Precision == PRECISION_16BIT ? (unsigned short)readU8() : readU16();
+  }
+  int readInteger()
+  {
+    return Precision == PRECISION_16BIT ? (int)readS16() : readS32();
+  }
+  double readAngle()
+  {
+    unsigned char data[Decoder::SIZE];
+    readBytes(data, Decoder::SIZE);
+    return Decoder::angle(data);
+  }
+  void readCoordinatePairs(unsigned pointNum, std::vector<std::pair<double, double> > &points, bool swap = false)
+  {
+    if (m_failed || !pointNum)
+      return;
+    const unsigned long spanSize = 2 * Decoder::SIZE * (unsigned long)pointNum;
+    unsigned long numBytes = 0;
+    const unsigned char *p = m_input->peekSpan(spanSize, spanSize, numBytes);
+    if (!p)
+    {
+      m_failed = true;
+      return;
+    }
+    detail::decodeCoordinatePairs<BigEndian, Precision>(p, pointNum, points, swap);
+    m_input->seek(long(spanSize), librevenge::RVNG_SEEK_CUR);
+  }
+
+private:
+  void readBytes(unsigned char *data, unsigned long numBytes)
+  {
+    if (!m_failed && m_input->readInto(data, numBytes) == numBytes)
+      return;
+    memset(data, 0, numBytes);
+    m_failed = true;
+  }
+
+  librevenge::RVNGInputStream *m_input;
+  const long m_start;
+  bool m_failed;
+};
+
+/* Gives the data from the current position of input to its end, if
+   input keeps them in memory */
+bool getMemorySpan(librevenge::RVNGInputStream *input, const unsigned char *&data, unsigned long &size);
+
+} // namespace libcdr
+
+#endif // __CDRRECORDCURSOR_H__
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,109 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libcdr project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "CDRRecordTape.h"
+
+#include "CDRInternalStream.h"
+#include "CDRDocumentStructure.h"
+
+libcdr::CDRRecordTape::CDRRecordTape()
+  : m_entries(), m_streams(), m_pages(), m_isInPage(false), m_pageLevel(0), m_isPageProperties(false),
+    m_isPageIgnored(false), m_vectLevel(0)
+{
+}
+
+libcdr::CDRRecordTape::~CDRRecordTape()
+{
+}
+
+void libcdr::CDRRecordTape::clear()
+{
+  m_entries.clear();
+  m_streams.clear();
+  m_pages.clear();
+  m_isInPage = false;
+  m_pageLevel = 0;
+  m_isPageProperties = false;
+  m_isPageIgnored = false;
+  m_vectLevel = 0;
+}
+
+void libcdr::CDRRecordTape::addEntry(const Entry &entry)
+{
+  if (m_isInPage && entry.level <= m_pageLevel)
+    m_isInPage = false;
+  if (m_vectLevel && entry.level <= m_vectLevel)
+    m_vectLevel = 0;
+  m_entries.push_back(entry);
+  if (m_isInPage)
+    m_pages.back().end = m_entries.size();
+}
+
+void libcdr::CDRRecordTape::addLevel(unsigned level, long position)
+{
+  Entry entry = { level, 0, 0, INPUT_STREAM, 0, 0, position };
+  addEntry(entry);
+}
+
+void libcdr::CDRRecordTape::addList(unsigned level, unsigned fourCC, unsigned listType, long position)
+{
+  Entry entry = { level, fourCC, listType, INPUT_STREAM, 0, 0, position };
+  addEntry(entry);
+  if (listType == CDR_FOURCC_page)
+  {
+    Page page = { m_entries.size() - 1, m_entries.size(), false };
+    m_pages.push_back(page);
+    m_isInPage = true;
+    m_pageLevel = level;
+    m_isPageProperties = true;
+    m_isPageIgnored = false;
+  }
+  else if (listType == CDR_FOURCC_obj || listType == CDR_FOURCC_grp || listType == CDR_FOURCC_lnkg)
+  {
+    if (m_isInPage && !m_vectLevel && !m_isPageIgnored)
+      m_pages.back().isDrawn = true;
+  }
+  else if (listType == CDR_FOURCC_vect || listType == CDR_FOURCC_clpt)
+    m_vectLevel = level;
+}
+
+void libcdr::CDRRecordTape::addRecord(unsigned level, unsigned fourCC, unsigned stream, unsigned long offset, unsigned length, long position)
+{
+  Entry entry = { level, fourCC, 0, stream, offset, length, position };
+  addEntry(entry);
+}
+
+void libcdr::CDRRecordTape::addFlags(unsigned flags, bool considerFlags)
+{
+  if (m_isInPage && m_isPageProperties)
+  {
+    if (!(flags & 0x00ff0000))
+      m_pages.back().isDrawn = true;
+    else if (considerFlags)
+      m_isPageIgnored = true;
+  }
+  m_isPageProperties = false;
+}
+
+unsigned libcdr::CDRRecordTape::addStream(const CDRInternalStream &stream)
+{
+  Stream tapeStream = { stream.getBuffer(), stream.getSize() };
+  m_streams.push_back(tapeStream);
+  return unsigned(m_streams.size() - 1);
+}
+
+librevenge::RVNGInputStream *libcdr::CDRRecordTape::createStream(unsigned stream) const
+{
+  if (stream >= m_streams.size())
+    return nullptr;
+  const Stream &tapeStream = m_streams[stream];
+  return new CDRInternalStream(tapeStream.buffer, tapeStream.size);
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,116 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libcdr project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef __CDRRECORDTAPE_H__
+#define __CDRRECORDTAPE_H__
+
+#include <memory>
+#include <vector>
+
+#include <librevenge-stream/librevenge-stream.h>
+
+namespace libcdr
+{
+
+class CDRInternalStream;
+
+/* The sequence of records met while parsing a document, together with
+   the data of the lists they were read from.
+
+   The first pass over a document records it, and the following passes
+   replay it, so that they neither read the input again nor decompress
+   the cmpr lists again. The tape also indexes the page lists, so that
+   a replay can skip the pages it does not need. */
+class CDRRecordTape
+{
+public:
+  /* Index of the stream standing for the input itself */
+  static const unsigned INPUT_STREAM = (unsigned)-1;
+
+  struct Entry
+  {
+    unsigned level;
+    /* 0 if the entry only sets the level */
+    unsigned fourCC;
+    unsigned listType;
+    unsigned stream;
+    unsigned long offset;
+    unsigned length;
+    /* The offset in the document the entry was read at, for the
+       progress of the replays; -1 if it is not known */
+    long position;
+  };
+
+  /* The entries of a page list, from the list itself to the last
+     entry inside it. The pages which are not drawn, like the master
+     page, are kept, so that their styles can still be read. A page is
+     drawn as CDRContentCollector starts it: by its first flags, or by
+     its first object or group */
+  struct Page
+  {
+    size_t begin;
+    size_t end;
+    bool isDrawn;
+  };
+
+  CDRRecordTape();
+  ~CDRRecordTape();
+
+  void clear();
+  bool empty() const
+  {
+    return m_entries.empty();
+  }
+  const std::vector<Entry> &getEntries() const
+  {
+    return m_entries;
+  }
+  const std::vector<Page> &getPages() const
+  {
+    return m_pages;
+  }
+
+  void addLevel(unsigned level, long position);
+  void addList(unsigned level, unsigned fourCC, unsigned listType, long position);
+  void addRecord(unsigned level, unsigned fourCC, unsigned stream, unsigned long offset, unsigned length, long position);
+  /* Takes the flags of a flgs record; the first ones of a page list
+     tell whether the page is drawn */
+  void addFlags(unsigned flags, bool considerFlags);
+
+  /* Adds a stream reading the data of a list, sharing its buffer */
+  unsigned addStream(const CDRInternalStream &stream);
+  /* Creates a new stream reading the data of a recorded stream */
+  librevenge::RVNGInputStream *createStream(unsigned stream) const;
+
+private:
+  struct Stream
+  {
+    std::shared_ptr<const unsigned char> buffer;
+    unsigned long size;
+  };
+
+  CDRRecordTape(const CDRRecordTape &);
+  CDRRecordTape &operator=(const CDRRecordTape &);
+
+  void addEntry(const Entry &entry);
+
+  std::vector<Entry> m_entries;
+  std::vector<Stream> m_streams;
+  std::vector<Page> m_pages;
+  bool m_isInPage;
+  unsigned m_pageLevel;
+  bool m_isPageProperties;
+  bool m_isPageIgnored;
+  unsigned m_vectLevel;
+};
+
+} // namespace libcdr
+
+#endif // __CDRRECORDTAPE_H__
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -26,138 +26,11 @@ libcdr::CDRStylesCollector::~CDRStylesCollector()
 {
 }
 
-void libcdr::CDRStylesCollector::collectBmp(unsigned imageId, unsigned colorModel, unsigned width, unsigned height, unsigned bpp, const std::vector<unsigned> &palette, const std::vector<unsigned char> &bitmap)
+void libcdr::CDRStylesCollector::collectBmp(unsigned imageId, const CDRBitmap &bitmap)
 {
-  libcdr::CDRInternalStream stream(bitmap);
-  librevenge::RVNGBinaryData image;
-
-  if (height == 0)
-    height = 1;
-
-  auto tmpPixelSize = (unsigned)(height * width);
-  if (tmpPixelSize < (unsigned)height) // overflow
-    return;
-
-  unsigned tmpDIBImageSize = tmpPixelSize * 4;
-  if (tmpPixelSize > tmpDIBImageSize) // overflow !!!
-    return;
-
-  unsigned tmpDIBOffsetBits = 14 + 40;
-  unsigned tmpDIBFileSize = tmpDIBOffsetBits + tmpDIBImageSize;
-  if (tmpDIBImageSize > tmpDIBFileSize) // overflow !!!
-    return;
-
-  // Create DIB file header
-  writeU16(image, 0x4D42);  // Type
-  writeU32(image, tmpDIBFileSize); // Size
-  writeU16(image, 0); // Reserved1
-  writeU16(image, 0); // Reserved2
-  writeU32(image, tmpDIBOffsetBits); // OffsetBits
-
-  // Create DIB Info header
-  writeU32(image, 40); // Size
-
-  writeU32(image, width);  // Width
-  writeU32(image, height); // Height
-
-  writeU16(image, 1); // Planes
-  writeU16(image, 32); // BitCount
-  writeU32(image, 0); // Compression
-  writeU32(image, tmpDIBImageSize); // SizeImage
-  writeU32(image, 0); // XPelsPerMeter
-  writeU32(image, 0); // YPelsPerMeter
-  writeU32(image, 0); // ColorsUsed
-  writeU32(image, 0); // ColorsImportant
-
-  // Cater for eventual padding
-  unsigned lineWidth = bitmap.size() / height;
-
-  bool storeBMP = true;
-
-  for (unsigned j = 0; j < height; ++j)
-  {
-    unsigned i = 0;
-    unsigned k = 0;
-    if (colorModel == 6)
-    {
-      while (i <lineWidth && k < width)
-      {
-        unsigned l = 0;
-        unsigned char c = bitmap[j*lineWidth+i];
-        i++;
-        while (k < width && l < 8)
-        {
-          if (c & 0x80)
-            writeU32(image, 0xffffff);
-          else
-            writeU32(image, 0);
-          c <<= 1;
-          l++;
-          k++;
-        }
-      }
-    }
-    else if (colorModel == 5)
-    {
-      while (i <lineWidth && i < width)
-      {
-        unsigned char c = bitmap[j*lineWidth+i];
-        i++;
-        writeU32(image, m_ps.getBMPColor(libcdr::CDRColor(colorModel, c)));
-      }
-    }
-    else if (!palette.empty())
-    {
-      while (i < lineWidth && i < width)
-      {
-        unsigned char c = bitmap[j*lineWidth+i];
-        if (c >= palette.size())
-          c = palette.size() - 1;
-        i++;
-        writeU32(image, m_ps.getBMPColor(libcdr::CDRColor(colorModel, palette[c])));
-      }
-    }
-    else if (bpp == 24 && lineWidth >= 3)
-    {
-      while (i < lineWidth -2 && k < width)
-      {
-        unsigned c = ((unsigned)bitmap[j*lineWidth+i+2] << 16) | ((unsigned)bitmap[j*lineWidth+i+1] << 8) | ((unsigned)bitmap[j*lineWidth+i]);
-        i += 3;
-        writeU32(image, m_ps.getBMPColor(libcdr::CDRColor(colorModel, c)));
-        k++;
-      }
-    }
-    else if (bpp == 32 && lineWidth >= 4)
-    {
-      while (i < lineWidth - 3 && k < width)
-      {
-        unsigned c = (bitmap[j*lineWidth+i+3] << 24) | (bitmap[j*lineWidth+i+2] << 16) | (bitmap[j*lineWidth+i+1] << 8) | (bitmap[j*lineWidth+i]);
-        i += 4;
-        writeU32(image, m_ps.getBMPColor(libcdr::CDRColor(colorModel, c)));
-        k++;
-      }
-    }
-    else
-      storeBMP = false;
-  }
-
-  if (storeBMP)
-  {
-#if DUMP_IMAGE
-    librevenge::RVNGString filename;
-    filename.sprintf("bitmap%.8x.bmp", imageId);
-    FILE *f = fopen(filename.cstr(), "wb");
-    if (f)
-    {
-      const unsigned char *tmpBuffer = image.getDataBuffer();
-      for (unsigned long k = 0; k < image.size(); k++)
-        fprintf(f, "%c",tmpBuffer[k]);
-      fclose(f);
-    }
-#endif
-
-    m_ps.m_bmps[imageId] = image;
-  }
+  // converted when a page draws it
+  if (m_ps.canConvertBitmap(bitmap))
+    m_ps.m_bmps.addBitmap(imageId, bitmap);
 }
 
 void libcdr::CDRStylesCollector::collectBmp(unsigned imageId, const std::vector<unsigned char> &bitmap)
@@ -176,7 +49,7 @@ void libcdr::CDRStylesCollector::collectBmp(unsigned imageId, const std::vector<
   }
 #endif
 
-  m_ps.m_bmps[imageId] = image;
+  m_ps.m_bmps.addImage(imageId, image);
 }
 
 void libcdr::CDRStylesCollector::collectPageSize(double width, double height, double offsetX, double offsetY)
@@ -231,7 +104,7 @@ void libcdr::CDRStylesCollector::collectText(unsigned textId, unsigned styleId,
     if (charDescriptions[i] != tmpCharDescription)
     {
       librevenge::RVNGString text;
-      if (!tmpTextData.empty())
+      if (!tmpTextData.empty() && m_ps.m_options.analyseText)
       {
         if (tmpCharDescription & 0x01)
           appendCharacters(text, tmpTextData);
@@ -248,7 +121,7 @@ void libcdr::CDRStylesCollector::collectText(unsigned textId, unsigned styleId,
       tmpTextData.push_back(data[j++]);
   }
   librevenge::RVNGString text;
-  if (!tmpTextData.empty())
+  if (!tmpTextData.empty() && m_ps.m_options.analyseText)
   {
     if (tmpCharDescription & 0x01)
       appendCharacters(text, tmpTextData);
@@ -49,7 +49,7 @@ public:
   void collectPageSize(double width, double height, double offsetX, double offsetY) override;
   void collectPolygonTransform(unsigned, unsigned, double, double, double, double) override {}
   void collectBitmap(unsigned, double, double, double, double) override {}
-  void collectBmp(unsigned imageId, unsigned colorModel, unsigned width, unsigned height, unsigned bpp, const std::vector<unsigned> &palette, const std::vector<unsigned char> &bitmap) override;
+  void collectBmp(unsigned imageId, const CDRBitmap &bitmap) override;
   void collectBmp(unsigned imageId, const std::vector<unsigned char> &bitmap) override;
   void collectBmpf(unsigned patternId, unsigned width, unsigned height, const std::vector<unsigned char> &pattern) override;
   void collectPpdt(const std::vector<std::pair<double, double> > &, const std::vector<unsigned> &) override {}
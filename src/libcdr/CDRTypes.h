@@ -10,6 +10,7 @@
 #ifndef __CDRTYPES_H__
 #define __CDRTYPES_H__
 
+#include <memory>
 #include <utility>
 #include <vector>
 #include <math.h>
@@ -234,10 +235,11 @@ struct CDRBitmap
   unsigned height;
   unsigned bpp;
   std::vector<unsigned> palette;
-  std::vector<unsigned char> bitmap;
-  CDRBitmap() : colorModel(0), width(0), height(0), bpp(0), palette(), bitmap() {}
-  CDRBitmap(unsigned cm, unsigned w, unsigned h, unsigned b, const std::vector<unsigned> &p, const std::vector<unsigned char> &bmp)
-    : colorModel(cm), width(w), height(h), bpp(b), palette(p), bitmap(bmp) {}
+  /* The pixels, shared with the data of the record they were read from
+     when those are kept in memory */
+  std::shared_ptr<const unsigned char> bitmap;
+  unsigned long bitmapSize;
+  CDRBitmap() : colorModel(0), width(0), height(0), bpp(0), palette(), bitmap(), bitmapSize(0) {}
 };
 
 struct CDRPage
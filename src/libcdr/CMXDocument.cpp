@@ -7,11 +7,14 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include <memory>
+
 #include <libcdr/libcdr.h>
 #include "CDRDocumentStructure.h"
 #include "CMXParser.h"
 #include "CDRContentCollector.h"
 #include "CDRStylesCollector.h"
+#include "CDRParseTracker.h"
 #include "libcdr_utils.h"
 
 /**
@@ -56,15 +59,32 @@ CDRPaintInterface class implementation when needed. This is often commonly calle
 \return A value that indicates whether the parsing was successful
 */
 CDRAPI bool libcdr::CMXDocument::parse(librevenge::RVNGInputStream *input, librevenge::RVNGDrawingInterface *painter)
+{
+  return parse(input, painter, CDRParseOptions());
+}
+
+/**
+Parses the input stream content with the features turned on by options. The
+document is always parsed in a single thread.
+\param input The input stream
+\param painter A CDRPainterInterface implementation
+\param options The features of the parse
+\return A value that indicates whether the parsing was successful
+*/
+CDRAPI bool libcdr::CMXDocument::parse(librevenge::RVNGInputStream *input, librevenge::RVNGDrawingInterface *painter, const CDRParseOptions &options)
 {
   if (!input || !painter)
     return false;
 
+  std::unique_ptr<CDRParseTracker> tracker(options.control ? new CDRParseTracker(*options.control) : nullptr);
+  if (tracker)
+    tracker->setTotalBytes(getLength(input));
   input->seek(0, librevenge::RVNG_SEEK_SET);
-  CDRParserState ps;
+  CDRParserState ps(options, tracker.get());
   CDRStylesCollector stylesCollector(ps);
   CMXParserState parserState;
   CMXParser stylesParser(&stylesCollector, parserState);
+  stylesParser.setParseTracker(tracker.get());
   bool retVal = stylesParser.parseRecords(input);
   if (ps.m_pages.empty())
     retVal = false;
@@ -73,9 +93,10 @@ CDRAPI bool libcdr::CMXDocument::parse(librevenge::RVNGInputStream *input, libre
     input->seek(0, librevenge::RVNG_SEEK_SET);
     CDRContentCollector contentCollector(ps, painter, false);
     CMXParser contentParser(&contentCollector, parserState);
+    contentParser.setParseTracker(tracker.get());
     retVal = contentParser.parseRecords(input);
   }
-  return retVal;
+  return tracker ? tracker->finish(retVal) : retVal;
 }
 
 /* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -19,6 +19,7 @@
 #include "libcdr_utils.h"
 #include "CDRPath.h"
 #include "CDRCollector.h"
+#include "CDRParseTracker.h"
 #include "CDRDocumentStructure.h"
 #include "CMXDocumentStructure.h"
 
@@ -107,6 +108,8 @@ bool libcdr::CMXParser::parseRecord(librevenge::RVNGInputStream *input, unsigned
   }
   try
   {
+    if (m_tracker && !m_tracker->checkRecord(input->tell()))
+      return false;
     m_collector->collectLevel(level);
     while (!input->isEnd() && readU8(input, m_bigEndian) == 0)
     {
@@ -419,6 +422,9 @@ void libcdr::CMXParser::readCommands(librevenge::RVNGInputStream *input, unsigne
   long endPosition = length + input->tell();
   while (!input->isEnd() && endPosition > input->tell())
   {
+    // parseRecord returns false once the tracker has stopped
+    if (m_tracker && !m_tracker->checkRecord(input->tell()))
+      return;
     long startPosition = input->tell();
     int instructionSize = readS16(input, m_bigEndian);
     int minInstructionSize = 4;
@@ -619,15 +625,8 @@ void libcdr::CMXParser::readPolyCurve(librevenge::RVNGInputStream *input)
           pointNum = getRemainingLength(input) / (2 * 4 + 1);
         points.reserve(pointNum);
         pointTypes.reserve(pointNum);
-        for (unsigned i = 0; i < pointNum; ++i)
-        {
-          std::pair<double, double> point;
-          point.first = readCoordinate(input, m_bigEndian);
-          point.second = readCoordinate(input, m_bigEndian);
-          points.push_back(point);
-        }
-        for (unsigned j = 0; j < pointNum; ++j)
-          pointTypes.push_back(readU8(input, m_bigEndian));
+        readCoordinatePairs(input, pointNum, points, m_bigEndian);
+        readU8Array(input, pointNum, pointTypes);
         break;
       default:
         break;
@@ -645,15 +644,8 @@ void libcdr::CMXParser::readPolyCurve(librevenge::RVNGInputStream *input)
     const unsigned long maxPoints = getRemainingLength(input) / (2 * 2 + 1);
     if (pointNum > maxPoints)
       pointNum = maxPoints;
-    for (unsigned i = 0; i < pointNum; ++i)
-    {
-      std::pair<double, double> point;
-      point.first = readCoordinate(input, m_bigEndian);
-      point.second = readCoordinate(input, m_bigEndian);
-      points.push_back(point);
-    }
-    for (unsigned j = 0; j < pointNum; ++j)
-      pointTypes.push_back(readU8(input, m_bigEndian));
+    readCoordinatePairs(input, pointNum, points, m_bigEndian);
+    readU8Array(input, pointNum, pointTypes);
   }
   else
     return;
@@ -2019,9 +2011,8 @@ void libcdr::CMXParser::readIxef(librevenge::RVNGInputStream *input)
       input->seek(offset, librevenge::RVNG_SEEK_SET);
       parseImage(input);
       input->seek(oldOffset, librevenge::RVNG_SEEK_SET);
-      if (m_currentBitmap && !(m_currentBitmap->bitmap.empty()))
-        m_collector->collectBmp(j, m_currentBitmap->colorModel, m_currentBitmap->width, m_currentBitmap->height,
-                                m_currentBitmap->bpp, m_currentBitmap->palette, m_currentBitmap->bitmap);
+      if (m_currentBitmap && m_currentBitmap->bitmapSize)
+        m_collector->collectBmp(j, *m_currentBitmap);
       m_currentBitmap = nullptr;
     }
     if (sizeInFile)
@@ -2175,7 +2166,7 @@ void libcdr::CMXParser::readData(librevenge::RVNGInputStream *input)
           m_currentBitmap.reset(new libcdr::CDRBitmap());
           readRImage(m_currentBitmap->colorModel, m_currentBitmap->width, m_currentBitmap->height,
                      m_currentBitmap->bpp, m_currentBitmap->palette, m_currentBitmap->bitmap,
-                     input, m_bigEndian);
+                     m_currentBitmap->bitmapSize, input, m_bigEndian);
         }
         break;
       }
@@ -2203,7 +2194,7 @@ void libcdr::CMXParser::readData(librevenge::RVNGInputStream *input)
       m_currentBitmap.reset(new libcdr::CDRBitmap());
       readRImage(m_currentBitmap->colorModel, m_currentBitmap->width, m_currentBitmap->height,
                  m_currentBitmap->bpp, m_currentBitmap->palette, m_currentBitmap->bitmap,
-                 input, m_bigEndian);
+                 m_currentBitmap->bitmapSize, input, m_bigEndian);
     }
   }
   else
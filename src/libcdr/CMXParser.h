@@ -108,6 +108,7 @@ public:
   explicit CMXParser(CDRCollector *collector, CMXParserState &parserState);
   ~CMXParser() override;
   bool parseRecords(librevenge::RVNGInputStream *input, long size = -1, unsigned level = 0);
+  using CommonParser::setParseTracker;
 
 private:
   CMXParser();
@@ -12,16 +12,46 @@
 #include <string.h>
 
 #include "CDRCollector.h"
+#include "CDRInternalStream.h"
 #include "CDRPath.h"
+#include "CDRRecordCursor.h"
 #include "libcdr_utils.h"
 
+namespace
+{
+
+/* Reads size bytes of input, sharing them with input when it keeps its
+   data in memory, and copying them otherwise. Returns an empty pointer
+   if input is too short */
+std::shared_ptr<const unsigned char> readSharedData(librevenge::RVNGInputStream *input, unsigned long size)
+{
+  unsigned long numBytesRead = 0;
+  const unsigned char *data = input->read(size, numBytesRead);
+  if (!data || numBytesRead != size)
+    return std::shared_ptr<const unsigned char>();
+  if (auto internalStream = dynamic_cast<libcdr::CDRInternalStream *>(input))
+  {
+    if (internalStream->getBuffer())
+      return std::shared_ptr<const unsigned char>(internalStream->getBuffer(), data);
+  }
+  auto copy = std::make_shared<std::vector<unsigned char> >(data, data + size);
+  return std::shared_ptr<const unsigned char>(copy, &(*copy)[0]);
+}
+
+} // anonymous namespace
+
 libcdr::CommonParser::CommonParser(libcdr::CDRCollector *collector)
-  : m_collector(collector), m_precision(libcdr::PRECISION_UNKNOWN) {}
+  : m_collector(collector), m_precision(libcdr::PRECISION_UNKNOWN), m_tracker(nullptr) {}
 
 libcdr::CommonParser::~CommonParser()
 {
 }
 
+void libcdr::CommonParser::setParseTracker(CDRParseTracker *tracker)
+{
+  m_tracker = tracker;
+}
+
 double libcdr::CommonParser::readCoordinate(librevenge::RVNGInputStream *input, bool bigEndian)
 {
   if (m_precision == PRECISION_UNKNOWN)
@@ -31,6 +61,44 @@ double libcdr::CommonParser::readCoordinate(librevenge::RVNGInputStream *input,
   return (double)readS32(input, bigEndian) / 254000.0;
 }
 
+void libcdr::CommonParser::readCoordinatePairs(librevenge::RVNGInputStream *input, unsigned pointNum,
+                                               std::vector<std::pair<double, double> > &points,
+                                               bool bigEndian, bool swap)
+{
+  if (m_precision == PRECISION_UNKNOWN)
+    throw UnknownPrecisionException();
+  if (!pointNum)
+    return;
+  const unsigned long coordSize = m_precision == PRECISION_16BIT ? 2 : 4;
+  const unsigned long spanSize = 2 * coordSize * pointNum;
+  unsigned long numBytes = 0;
+  const unsigned char *p = input->peekSpan(spanSize, spanSize, numBytes);
+  points.reserve(points.size() + pointNum);
+  if (!p)
+  {
+    // not enough data: read them one by one, until it throws at the end
+    for (unsigned j = 0; j < pointNum; j++)
+    {
+      const double first = readCoordinate(input, bigEndian);
+      const double second = readCoordinate(input, bigEndian);
+      points.push_back(swap ? std::make_pair(second, first) : std::make_pair(first, second));
+    }
+    return;
+  }
+  if (m_precision == PRECISION_16BIT)
+  {
+    if (bigEndian)
+      detail::decodeCoordinatePairs<true, PRECISION_16BIT>(p, pointNum, points, swap);
+    else
+      detail::decodeCoordinatePairs<false, PRECISION_16BIT>(p, pointNum, points, swap);
+  }
+  else if (bigEndian)
+    detail::decodeCoordinatePairs<true, PRECISION_32BIT>(p, pointNum, points, swap);
+  else
+    detail::decodeCoordinatePairs<false, PRECISION_32BIT>(p, pointNum, points, swap);
+  input->seek((long)spanSize, librevenge::RVNG_SEEK_CUR);
+}
+
 unsigned libcdr::CommonParser::readUnsigned(librevenge::RVNGInputStream *input, bool bigEndian)
 {
   if (m_precision == PRECISION_UNKNOWN)
@@ -133,8 +201,8 @@ void libcdr::CommonParser::processPath(const std::vector<std::pair<double, doubl
 }
 
 void libcdr::CommonParser::readRImage(unsigned &colorModel, unsigned &width, unsigned &height, unsigned &bpp,
-                                      std::vector<unsigned> &palette, std::vector<unsigned char> &bitmap,
-                                      librevenge::RVNGInputStream *input, bool bigEndian)
+                                      std::vector<unsigned> &palette, std::shared_ptr<const unsigned char> &bitmap,
+                                      unsigned long &bitmapSize, librevenge::RVNGInputStream *input, bool bigEndian)
 {
   colorModel = readU32(input, bigEndian);
   input->seek(4, librevenge::RVNG_SEEK_CUR);
@@ -163,13 +231,11 @@ void libcdr::CommonParser::readRImage(unsigned &colorModel, unsigned &width, uns
   }
   if (bmpsize == 0)
     return;
-  unsigned long tmpNumBytesRead = 0;
-  const unsigned char *tmpBuffer = input->read(bmpsize, tmpNumBytesRead);
-  if (bmpsize != tmpNumBytesRead)
+  std::shared_ptr<const unsigned char> pixels = readSharedData(input, bmpsize);
+  if (!pixels)
     return;
-  bitmap.clear();
-  bitmap.resize(bmpsize);
-  memcpy(&bitmap[0], tmpBuffer, bmpsize);
+  bitmap = pixels;
+  bitmapSize = bmpsize;
 }
 
 void libcdr::CommonParser::readBmpPattern(unsigned &width, unsigned &height, std::vector<unsigned char> &pattern,
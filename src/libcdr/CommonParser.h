@@ -10,6 +10,7 @@
 #ifndef __COMMONPARSER_H__
 #define __COMMONPARSER_H__
 
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -19,6 +20,7 @@ namespace libcdr
 {
 
 class CDRCollector;
+class CDRParseTracker;
 class CDRPath;
 
 enum CoordinatePrecision
@@ -29,6 +31,9 @@ class CommonParser
 public:
   CommonParser(CDRCollector *collector);
   virtual ~CommonParser();
+  /* Makes the parser check tracker at every record, and stop once it
+     is stopped */
+  void setParseTracker(CDRParseTracker *tracker);
 
 private:
   CommonParser();
@@ -38,13 +43,19 @@ private:
 
 protected:
   double readCoordinate(librevenge::RVNGInputStream *input, bool bigEndian = false);
+  /* Appends pointNum pairs of coordinates to points, decoding them from a
+     single span of the stream. If swap is true, the first coordinate of
+     each pair goes to second. */
+  void readCoordinatePairs(librevenge::RVNGInputStream *input, unsigned pointNum,
+                           std::vector<std::pair<double, double> > &points,
+                           bool bigEndian = false, bool swap = false);
   unsigned readUnsigned(librevenge::RVNGInputStream *input, bool bigEndian = false);
   unsigned short readUnsignedShort(librevenge::RVNGInputStream *input, bool bigEndian = false);
   int readInteger(librevenge::RVNGInputStream *input, bool bigEndian = false);
   double readAngle(librevenge::RVNGInputStream *input, bool bigEndian = false);
   void readRImage(unsigned &colorModel, unsigned &width, unsigned &height, unsigned &bpp,
-                  std::vector<unsigned> &palette, std::vector<unsigned char> &bitmap,
-                  librevenge::RVNGInputStream *input, bool bigEndian = false);
+                  std::vector<unsigned> &palette, std::shared_ptr<const unsigned char> &bitmap,
+                  unsigned long &bitmapSize, librevenge::RVNGInputStream *input, bool bigEndian = false);
   void readBmpPattern(unsigned &width, unsigned &height, std::vector<unsigned char> &pattern,
                       unsigned length, librevenge::RVNGInputStream *input, bool bigEndian = false);
 
@@ -53,6 +64,7 @@ protected:
 
   CDRCollector *m_collector;
   CoordinatePrecision m_precision;
+  CDRParseTracker *m_tracker;
 };
 } // namespace libcdr
 
@@ -14,6 +14,8 @@
 #include <cstdio>
 #include <string.h>
 
+#include "CDRInternalStream.h"
+
 #ifdef CRD_TEXT
 #include <unicode/ucsdet.h>
 #include <unicode/ucnv.h>
@@ -171,12 +173,13 @@ static void _appendUCS4(librevenge::RVNGString &text, UChar32 ucs4Character)
 
 uint8_t libcdr::readU8(librevenge::RVNGInputStream *input, bool /* bigEndian */)
 {
-  if (!input || input->isEnd())
+  // no need to ask isEnd(): the read is short at the end of the stream
+  if (!input)
   {
     CDR_DEBUG_MSG(("Throwing EndOfStreamException\n"));
     throw EndOfStreamException();
   }
-  unsigned long numBytesRead;
+  unsigned long numBytesRead = 0;
   uint8_t const *p = input->read(sizeof(uint8_t), numBytesRead);
 
   if (p && numBytesRead == sizeof(uint8_t))
@@ -187,12 +190,13 @@ uint8_t libcdr::readU8(librevenge::RVNGInputStream *input, bool /* bigEndian */)
 
 uint16_t libcdr::readU16(librevenge::RVNGInputStream *input, bool bigEndian)
 {
-  if (!input || input->isEnd())
+  // no need to ask isEnd(): the read is short at the end of the stream
+  if (!input)
   {
     CDR_DEBUG_MSG(("Throwing EndOfStreamException\n"));
     throw EndOfStreamException();
   }
-  unsigned long numBytesRead;
+  unsigned long numBytesRead = 0;
   uint8_t const *p = input->read(sizeof(uint16_t), numBytesRead);
 
   if (p && numBytesRead == sizeof(uint16_t))
@@ -212,12 +216,13 @@ int16_t libcdr::readS16(librevenge::RVNGInputStream *input, bool bigEndian)
 
 uint32_t libcdr::readU32(librevenge::RVNGInputStream *input, bool bigEndian)
 {
-  if (!input || input->isEnd())
+  // no need to ask isEnd(): the read is short at the end of the stream
+  if (!input)
   {
     CDR_DEBUG_MSG(("Throwing EndOfStreamException\n"));
     throw EndOfStreamException();
   }
-  unsigned long numBytesRead;
+  unsigned long numBytesRead = 0;
   uint8_t const *p = input->read(sizeof(uint32_t), numBytesRead);
 
   if (p && numBytesRead == sizeof(uint32_t))
@@ -237,12 +242,13 @@ int32_t libcdr::readS32(librevenge::RVNGInputStream *input, bool bigEndian)
 
 uint64_t libcdr::readU64(librevenge::RVNGInputStream *input, bool bigEndian)
 {
-  if (!input || input->isEnd())
+  // no need to ask isEnd(): the read is short at the end of the stream
+  if (!input)
   {
     CDR_DEBUG_MSG(("Throwing EndOfStreamException\n"));
     throw EndOfStreamException();
   }
-  unsigned long numBytesRead;
+  unsigned long numBytesRead = 0;
   uint8_t const *p = input->read(sizeof(uint64_t), numBytesRead);
 
   if (p && numBytesRead == sizeof(uint64_t))
@@ -255,6 +261,20 @@ uint64_t libcdr::readU64(librevenge::RVNGInputStream *input, bool bigEndian)
   throw EndOfStreamException();
 }
 
+void libcdr::readU8Array(librevenge::RVNGInputStream *input, unsigned long count, std::vector<unsigned char> &values)
+{
+  if (!input)
+    throw EndOfStreamException();
+  const size_t start = values.size();
+  values.resize(start + count);
+  if (input->readInto(values.data() + start, count) != count)
+  {
+    values.resize(start);
+    CDR_DEBUG_MSG(("Throwing EndOfStreamException\n"));
+    throw EndOfStreamException();
+  }
+}
+
 double libcdr::readDouble(librevenge::RVNGInputStream *input, bool bigEndian)
 {
   union
@@ -281,6 +301,10 @@ unsigned long libcdr::getLength(librevenge::RVNGInputStream *const input)
   if (!input)
     throw EndOfStreamException();
 
+  // the streams in memory know their size, no need to seek to the end
+  if (const auto *internalStream = dynamic_cast<const CDRInternalStream *>(input))
+    return internalStream->getSize();
+
   const long orig = input->tell();
   long end = 0;
 
@@ -79,6 +79,8 @@ uint32_t readU32(librevenge::RVNGInputStream *input, bool bigEndian=false);
 uint64_t readU64(librevenge::RVNGInputStream *input, bool bigEndian=false);
 int32_t readS32(librevenge::RVNGInputStream *input, bool bigEndian=false);
 int16_t readS16(librevenge::RVNGInputStream *input, bool bigEndian=false);
+/* Appends count bytes to values, with one read instead of one per byte. */
+void readU8Array(librevenge::RVNGInputStream *input, unsigned long count, std::vector<unsigned char> &values);
 
 double readDouble(librevenge::RVNGInputStream *input, bool bigEndian=false);
 
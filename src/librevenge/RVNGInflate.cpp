@@ -0,0 +1,106 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* librevenge
+ * Version: MPL 2.0 / LGPLv2.1+
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For minor contributions see the git repository.
+ *
+ * Alternatively, the contents of this file may be used under the terms
+ * of the GNU Lesser General Public License Version 2.1 or later
+ * (LGPLv2.1+), in which case the provisions of the LGPLv2.1+ are
+ * applicable instead of those above.
+ */
+
+#include "RVNGInflate.h"
+
+#include <zlib.h>
+
+#include "librevenge_internal.h"
+
+namespace librevenge
+{
+
+// deflate can not compress better than about 1:1032, so a bigger expected size is not trusted
+#define RVNG_INFLATE_MAX_RATIO 1032
+
+RVNGInflate::Result RVNGInflate::inflateBuffer(const unsigned char *data, unsigned long dataSize, bool rawDeflate,
+                                               unsigned long expectedSize, std::vector<unsigned char> &output,
+                                               unsigned long maxSize)
+{
+	output.clear();
+	if (!data || !dataSize)
+		return Failed;
+
+	if (expectedSize / RVNG_INFLATE_MAX_RATIO > dataSize)
+	{
+		RVNG_DEBUG_MSG(("RVNGInflate::inflateBuffer: the expected size %lu is not plausible\n", expectedSize));
+		expectedSize = 0;
+	}
+	const unsigned long growSize = 2 * dataSize > 4096 ? 2 * dataSize : 4096;
+
+	z_stream strm;
+	strm.zalloc = Z_NULL;
+	strm.zfree = Z_NULL;
+	strm.opaque = Z_NULL;
+	strm.avail_in = 0;
+	strm.next_in = Z_NULL;
+	if (inflateInit2(&strm, rawDeflate ? -MAX_WBITS : MAX_WBITS) != Z_OK)
+		return Failed;
+
+	// one more byte than expected lets us see the end of the stream without growing
+	unsigned long outputSize = expectedSize ? expectedSize + 1 : growSize;
+	if (outputSize > maxSize)
+		outputSize = maxSize + 1;
+	output.resize(size_t(outputSize));
+	strm.next_in = const_cast<Bytef *>(data);
+	strm.avail_in = uInt(dataSize);
+
+	Result result = Failed;
+	while (true)
+	{
+		strm.next_out = output.data() + strm.total_out;
+		strm.avail_out = uInt(output.size() - strm.total_out);
+		const uLong oldTotalOut = strm.total_out;
+		const int ret = inflate(&strm, Z_FINISH);
+		if (ret == Z_STREAM_END)
+		{
+			result = Done;
+			break;
+		}
+		if (ret != Z_OK && ret != Z_BUF_ERROR)
+			break;
+		if (strm.avail_out == 0)
+		{
+			if (output.size() > maxSize)
+			{
+				result = TooBig;
+				break;
+			}
+			// the sizes disagree, so grow the output
+			outputSize = output.size() + growSize;
+			if (outputSize > maxSize)
+				outputSize = maxSize + 1;
+			output.resize(size_t(outputSize));
+			continue;
+		}
+		if (strm.avail_in == 0 || strm.total_out == oldTotalOut)
+		{
+			result = Truncated;
+			break;
+		}
+	}
+
+	if (result == Failed)
+		output.clear();
+	else
+		output.resize(size_t(strm.total_out));
+	(void)inflateEnd(&strm);
+	return result;
+}
+
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 noexpandtab: */
@@ -0,0 +1,55 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* librevenge
+ * Version: MPL 2.0 / LGPLv2.1+
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For minor contributions see the git repository.
+ *
+ * Alternatively, the contents of this file may be used under the terms
+ * of the GNU Lesser General Public License Version 2.1 or later
+ * (LGPLv2.1+), in which case the provisions of the LGPLv2.1+ are
+ * applicable instead of those above.
+ */
+
+#ifndef RVNGINFLATE_H
+#define RVNGINFLATE_H
+
+#include <vector>
+
+namespace librevenge
+{
+
+class RVNGInflate
+{
+public:
+	enum Result
+	{
+		Done,      //!< the compressed data were completely inflated
+		Truncated, //!< the compressed data ended before the end of the deflate stream
+		TooBig,    //!< the inflated data would be bigger than the maximal size
+		Failed     //!< the compressed data are invalid
+	};
+
+	/** Inflates a buffer of compressed data in output.
+
+		\param rawDeflate true for raw deflate data (as in zip files), false for zlib data
+		\param expectedSize the uncompressed size if it is known, 0 otherwise
+		\param maxSize the maximal size of the inflated data
+
+		The output is allocated once with expectedSize and inflated in one
+		call; it is only grown if the data turn out to be bigger. On return,
+		output contains the inflated data, and is empty if the result is Failed.
+		If the result is TooBig, it contains the first maxSize + 1 bytes of them.
+	 */
+	static Result inflateBuffer(const unsigned char *data, unsigned long dataSize, bool rawDeflate,
+	                            unsigned long expectedSize, std::vector<unsigned char> &output,
+	                            unsigned long maxSize = (unsigned long)-1);
+};
+
+}
+
+#endif // RVNGINFLATE_H
+/* vim:set shiftwidth=4 softtabstop=4 noexpandtab: */
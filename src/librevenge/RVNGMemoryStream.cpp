@@ -20,6 +20,8 @@
 
 #include "RVNGMemoryStream.h"
 
+#include <string.h>
+
 namespace librevenge
 {
 
@@ -96,6 +98,21 @@ bool RVNGMemoryInputStream::isEnd()
 	return false;
 }
 
+unsigned long RVNGMemoryInputStream::readAt(unsigned long offset, unsigned long numBytes, unsigned char *buffer) const
+{
+	if (!buffer || offset >= m_size)
+		return 0;
+	if (numBytes > m_size - offset)
+		numBytes = m_size - offset;
+	memcpy(buffer, m_data + offset, numBytes);
+	return numBytes;
+}
+
+RVNGInputStream *RVNGMemoryInputStream::clone() const
+{
+	return new RVNGMemoryInputStream(m_data, m_size);
+}
+
 }
 
 /* vim:set shiftwidth=4 softtabstop=4 noexpandtab: */
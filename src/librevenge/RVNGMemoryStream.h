@@ -58,6 +58,8 @@ public:
 	int seek(long offset, RVNG_SEEK_TYPE seekType);
 	long tell();
 	bool isEnd();
+	unsigned long readAt(unsigned long offset, unsigned long numBytes, unsigned char *buffer) const;
+	RVNGInputStream *clone() const;
 	unsigned long getSize() const
 	{
 		return m_size;
@@ -53,11 +53,14 @@
 #include <locale>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <librevenge-stream/librevenge-stream.h>
 
 #include "librevenge_internal.h"
+#include "RVNGStreamBuffer.h"
+#include "RVNGZipStream.h"
 
 namespace librevenge
 {
@@ -296,7 +299,7 @@ class DirTree
 {
 public:
 	/** constructor */
-	DirTree() : m_entries()
+	DirTree() : m_entries(), m_nameIndex(), m_nameIndexBuilt(false)
 	{
 		clear();
 	}
@@ -415,6 +418,17 @@ protected:
 	                      std::vector<std::string> &res, std::set<unsigned> &seen,
 	                      bool isRoot=false) const;
 
+	/** returns the key used in the name index for a fullname, e.g. "ObjectPool/_1020961869" */
+	static std::string indexKey(const std::string &name);
+	/** fills the name index, with the same resolution rules as a walk using find_child */
+	void buildNameIndex(unsigned ind, const std::string &prefix, std::set<unsigned> &seen);
+	/** forgets the name index, must be called when the entries change */
+	void resetNameIndex()
+	{
+		m_nameIndex.clear();
+		m_nameIndexBuilt = false;
+	}
+
 	/** check that the subtrees of index is a red black tree, if not rebuild it */
 	void setInRedBlackTreeForm(unsigned id, std::set<unsigned> &seen);
 	/** rebuild all the childs m_left, m_right index as a red black
@@ -459,6 +473,9 @@ protected:
 
 private:
 	std::vector<DirEntry> m_entries;
+	//! the full name to entry index map, built on first lookup
+	std::unordered_map<std::string, unsigned> m_nameIndex;
+	bool m_nameIndexBuilt;
 	DirTree(const DirTree &);
 	DirTree &operator=(const DirTree &);
 };
@@ -682,6 +699,7 @@ private:
 
 class IStream
 {
+	friend class Storage;
 public:
 	IStorage *m_iStorage;
 	//! the stream size
@@ -735,6 +753,75 @@ private:
 	std::vector<unsigned char> m_data;
 };
 
+/** An input stream reading the sectors of a big block OLE substream on demand.
+
+	The last used sectors are kept in a small cache, and reads crossing a
+	sector boundary are assembled in a separate buffer.
+ */
+class RVNGOLEInputStream : public RVNGInputStream
+{
+public:
+	RVNGOLEInputStream(IStorage *storage, std::vector<unsigned long> const &blocks, unsigned long size);
+	~RVNGOLEInputStream();
+
+	bool isStructured();
+	unsigned subStreamCount();
+	const char *subStreamName(unsigned id);
+	bool existsSubStream(const char *name);
+	RVNGInputStream *getSubStreamByName(const char *name);
+	RVNGInputStream *getSubStreamById(unsigned id);
+	RVNGInputStream *getOnDemandSubStreamByName(const char *name);
+
+	const unsigned char *read(unsigned long numBytes, unsigned long &numBytesRead);
+	int seek(long offset, RVNG_SEEK_TYPE seekType);
+	long tell();
+	bool isEnd();
+	unsigned long readAt(unsigned long offset, unsigned long numBytes, unsigned char *buffer) const;
+	RVNGInputStream *clone() const;
+
+protected:
+	//! creates the substream name, reading it on demand if asked
+	RVNGInputStream *getSubStream(const char *name, bool onDemand);
+	//! returns the sector with index ind in the stream, loading it if needed
+	const unsigned char *sector(unsigned long ind);
+	//! loads the sectors [first, first+num) in data, returns the number of bytes read
+	unsigned long loadSectors(unsigned long first, unsigned long num, unsigned char *data);
+
+private:
+	enum StructureType { Unknown, Flat, OLE2, Zip };
+	enum { MaxCachedSectors = 16 };
+
+	struct CachedSector
+	{
+		CachedSector() : m_index(0), m_lastUse(0), m_data() {}
+		unsigned long m_index;
+		unsigned long m_lastUse;
+		std::vector<unsigned char> m_data;
+	};
+
+	IStorage *m_iStorage;
+	std::vector<unsigned long> m_blocks;
+	unsigned long m_size;
+	unsigned long m_sectorSize;
+	//! true if the sectors are read with the positional reads of the storage input
+	bool m_hasReadAt;
+	long m_offset;
+
+	std::vector<CachedSector> m_cache;
+	unsigned long m_useCount;
+	//! the buffer used for the reads crossing sector boundaries
+	std::vector<unsigned char> m_buffer;
+
+	StructureType m_structureType;
+	std::vector<std::string> m_streamNameList;
+	std::unique_ptr<Storage> m_storage;
+	std::unique_ptr<RVNGZipDirectory> m_zipDirectory;
+
+	// no copy or assign
+	RVNGOLEInputStream(const RVNGOLEInputStream &);
+	RVNGOLEInputStream &operator=(const RVNGOLEInputStream &);
+};
+
 } // namespace librevenge
 // =========== Header ==========
 
@@ -926,6 +1013,7 @@ void librevenge::DirEntry::save(unsigned char *buffer) const
 
 void librevenge::DirTree::clear()
 {
+	resetNameIndex();
 	m_entries.resize(0);
 	setRootType(true);
 }
@@ -957,6 +1045,18 @@ unsigned librevenge::DirTree::index(const std::string &name, bool create)
 	// quick check for "/" (that's root)
 	if (name == "/") return 0;
 
+	if (!create)
+	{
+		if (!m_nameIndexBuilt)
+		{
+			std::set<unsigned> seen;
+			buildNameIndex(0, "", seen);
+			m_nameIndexBuilt = true;
+		}
+		auto it = m_nameIndex.find(indexKey(name));
+		return it == m_nameIndex.end() ? unsigned(NotFound) : it->second;
+	}
+
 	// split the names, e.g  "/ObjectPool/_1020961869" will become:
 	// "ObjectPool" and "_1020961869"
 	std::list<std::string> names;
@@ -976,12 +1076,14 @@ unsigned librevenge::DirTree::index(const std::string &name, bool create)
 	// trace one by one
 	std::list<std::string>::const_iterator it;
 	size_t depth = 0;
+	std::string key;
 
 	for (it = names.begin(); it != names.end(); ++it, ++depth)
 	{
 		std::string childName(*it);
 		if (childName.length() && childName[0]<32)
 			childName= it->substr(1);
+		key = depth ? key + "/" + childName : childName;
 
 		unsigned child = find_child(ind, childName);
 		// traverse to the child
@@ -990,7 +1092,6 @@ unsigned librevenge::DirTree::index(const std::string &name, bool create)
 			ind = child;
 			continue;
 		}
-		else if (!create) return NotFound;
 
 		// create a new entry
 		unsigned parent = ind;
@@ -1003,13 +1104,61 @@ unsigned librevenge::DirTree::index(const std::string &name, bool create)
 		// e->m_start = Eof; CHECKME
 		e->m_left = entry(parent)->m_child;
 		entry(parent)->m_child = ind;
+		if (m_nameIndexBuilt)
+			m_nameIndex.insert(std::make_pair(key, ind));
 	}
 
 	return ind;
 }
 
+std::string librevenge::DirTree::indexKey(const std::string &name)
+{
+	// same splitting as index(): the components are joined back without
+	// the leading '/' and without their leading control character
+	std::string key;
+	std::string::size_type start = 0, end = 0;
+	bool first = true;
+	if (name.length() && name[0] == '/') start++;
+	while (start < name.length())
+	{
+		end = name.find_first_of('/', start);
+		if (end == std::string::npos) end = name.length();
+		if (!first)
+			key += '/';
+		first = false;
+		if (end > start && name[start] < 32)
+			key.append(name, start+1, end-start-1);
+		else
+			key.append(name, start, end-start);
+		start = end+1;
+	}
+	return key;
+}
+
+void librevenge::DirTree::buildNameIndex(unsigned ind, const std::string &prefix, std::set<unsigned> &seen)
+{
+	if (seen.find(ind) != seen.end())
+		return;
+	seen.insert(ind);
+	DirEntry const *p = entry(ind);
+	if (!p || !p->m_valid)
+		return;
+	std::vector<unsigned> siblings = get_siblings(p->m_child);
+	for (unsigned s : siblings)
+	{
+		DirEntry const *child = entry(s);
+		if (!child || s == 0)
+			continue;
+		std::string key = prefix.empty() && !ind ? child->name() : prefix + "/" + child->name();
+		// like find_child, the first sibling with a given name wins
+		if (m_nameIndex.insert(std::make_pair(key, s)).second)
+			buildNameIndex(s, key, seen);
+	}
+}
+
 void librevenge::DirTree::load(unsigned char *buffer, unsigned size)
 {
+	resetNameIndex();
 	m_entries.clear();
 
 	for (unsigned i = 0; i < size/128; i++)
@@ -1743,6 +1892,278 @@ bool librevenge::IStream::createOleFromDirectory(IStorage *io, std::string const
 	return false;
 }
 
+// =========== RVNGOLEInputStream ==========
+
+librevenge::RVNGOLEInputStream::RVNGOLEInputStream(IStorage *storage, std::vector<unsigned long> const &blocks, unsigned long size) :
+	RVNGInputStream(),
+	m_iStorage(storage),
+	m_blocks(blocks),
+	m_size(size),
+	m_sectorSize(storage->m_bbat.m_blockSize),
+	m_hasReadAt(false),
+	m_offset(0),
+	m_cache(),
+	m_useCount(0),
+	m_buffer(),
+	m_structureType(Unknown),
+	m_streamNameList(),
+	m_storage(),
+	m_zipDirectory()
+{
+	unsigned char byte = 0;
+	m_hasReadAt = !m_blocks.empty() && m_iStorage->m_input->readAt(m_sectorSize * (m_blocks[0] + 1), 1, &byte) == 1;
+}
+
+librevenge::RVNGOLEInputStream::~RVNGOLEInputStream()
+{
+}
+
+unsigned long librevenge::RVNGOLEInputStream::loadSectors(unsigned long first, unsigned long num, unsigned char *data)
+{
+	if (first >= m_blocks.size())
+		return 0;
+	if (num > m_blocks.size() - first)
+		num = (unsigned long)(m_blocks.size()) - first;
+	RVNGInputStream *input = m_iStorage->m_input;
+	if (m_hasReadAt)
+	{
+		// positional reads do not disturb the storage input, which the
+		// clones of this stream may be reading in other threads
+		unsigned long bytes = 0;
+		for (unsigned long i = 0; i < num; ++i)
+		{
+			const unsigned long numBytesRead = input->readAt(m_sectorSize * (m_blocks[first + i] + 1), m_sectorSize, data + bytes);
+			bytes += numBytesRead;
+			if (numBytesRead < m_sectorSize)
+				break;
+		}
+		return bytes;
+	}
+
+	// the storage input may be used by someone else, so restore its position
+	std::vector<unsigned long> blocks(m_blocks.begin() + long(first), m_blocks.begin() + long(first + num));
+	const long pos = input->tell();
+	const unsigned long bytes = m_iStorage->loadBigBlocks(blocks, data, num * m_sectorSize);
+	input->seek(pos, RVNG_SEEK_SET);
+	return bytes;
+}
+
+const unsigned char *librevenge::RVNGOLEInputStream::sector(unsigned long ind)
+{
+	CachedSector *slot = nullptr;
+	for (auto &cached : m_cache)
+	{
+		if (cached.m_index == ind)
+		{
+			cached.m_lastUse = ++m_useCount;
+			return cached.m_data.data();
+		}
+		if (!slot || cached.m_lastUse < slot->m_lastUse)
+			slot = &cached;
+	}
+	if (m_cache.size() < MaxCachedSectors)
+	{
+		m_cache.push_back(CachedSector());
+		slot = &m_cache.back();
+		slot->m_data.resize(m_sectorSize);
+	}
+	slot->m_index = ind;
+	slot->m_lastUse = ++m_useCount;
+	const unsigned long bytes = loadSectors(ind, 1, slot->m_data.data());
+	if (bytes < m_sectorSize)
+	{
+		// getSubStream checked that the input holds the stream, so only
+		// the bytes after its end can be missing, unless the input fails
+		RVNG_DEBUG_MSG(("librevenge::RVNGOLEInputStream::sector: can not read sector %lu\n", ind));
+		memset(slot->m_data.data() + bytes, 0, size_t(m_sectorSize - bytes));
+	}
+	return slot->m_data.data();
+}
+
+const unsigned char *librevenge::RVNGOLEInputStream::read(unsigned long numBytes, unsigned long &numBytesRead)
+{
+	numBytesRead = 0;
+
+	if (numBytes == 0 || m_offset < 0 || (unsigned long) m_offset >= m_size)
+		return nullptr;
+
+	auto pos = (unsigned long) m_offset;
+	if (numBytes > m_size - pos)
+		numBytes = m_size - pos;
+
+	const unsigned long first = pos / m_sectorSize;
+	const unsigned long last = (pos + numBytes - 1) / m_sectorSize;
+	const unsigned long offset = pos % m_sectorSize;
+	const unsigned char *data = nullptr;
+	if (first == last)
+		data = sector(first) + offset;
+	else
+	{
+		const unsigned long num = last - first + 1;
+		m_buffer.resize(size_t(num * m_sectorSize));
+		const unsigned long bytes = loadSectors(first, num, m_buffer.data());
+		if (bytes < m_buffer.size())
+			memset(m_buffer.data() + bytes, 0, m_buffer.size() - size_t(bytes));
+		data = m_buffer.data() + offset;
+	}
+
+	m_offset += long(numBytes);
+	numBytesRead = numBytes;
+	return data;
+}
+
+int librevenge::RVNGOLEInputStream::seek(long offset, RVNG_SEEK_TYPE seekType)
+{
+	if (seekType == RVNG_SEEK_CUR)
+		m_offset += offset;
+	else if (seekType == RVNG_SEEK_SET)
+		m_offset = offset;
+	else if (seekType == RVNG_SEEK_END)
+		m_offset = long(m_size) + offset;
+
+	if (m_offset < 0)
+	{
+		m_offset = 0;
+		return -1;
+	}
+	if (m_offset > long(m_size))
+	{
+		m_offset = long(m_size);
+		return -1;
+	}
+
+	return 0;
+}
+
+long librevenge::RVNGOLEInputStream::tell()
+{
+	return m_offset;
+}
+
+bool librevenge::RVNGOLEInputStream::isEnd()
+{
+	return m_offset >= long(m_size);
+}
+
+unsigned long librevenge::RVNGOLEInputStream::readAt(unsigned long offset, unsigned long numBytes, unsigned char *buffer) const
+{
+	if (!buffer || !m_sectorSize || offset >= m_size)
+		return 0;
+	if (numBytes > m_size - offset)
+		numBytes = m_size - offset;
+
+	const RVNGInputStream *input = m_iStorage->m_input;
+	unsigned long bytes = 0;
+	while (bytes < numBytes)
+	{
+		const unsigned long pos = offset + bytes;
+		const unsigned long ind = pos / m_sectorSize;
+		if (ind >= m_blocks.size())
+			break;
+		const unsigned long sectorOffset = pos % m_sectorSize;
+		unsigned long len = m_sectorSize - sectorOffset;
+		if (len > numBytes - bytes)
+			len = numBytes - bytes;
+		const unsigned long numBytesRead = input->readAt(m_sectorSize * (m_blocks[ind] + 1) + sectorOffset, len, buffer + bytes);
+		bytes += numBytesRead;
+		if (numBytesRead < len)
+			break;
+	}
+	return bytes;
+}
+
+librevenge::RVNGInputStream *librevenge::RVNGOLEInputStream::clone() const
+{
+	// without positional reads, the clone would move the shared storage input
+	if (!m_hasReadAt)
+		return nullptr;
+	return new RVNGOLEInputStream(m_iStorage, m_blocks, m_size);
+}
+
+bool librevenge::RVNGOLEInputStream::isStructured()
+{
+	if (!m_size)
+		return false;
+
+	if (m_structureType == Unknown)
+	{
+		seek(0, RVNG_SEEK_SET);
+
+		// Check whether it is OLE2 storage
+		std::unique_ptr<Storage> tmpStorage(new Storage(this));
+		if (tmpStorage->isStructured())
+		{
+			m_structureType = OLE2;
+			m_streamNameList = tmpStorage->getSubStreamNamesList();
+			m_storage = std::move(tmpStorage);
+			return true;
+		}
+		seek(0, RVNG_SEEK_SET);
+		std::unique_ptr<RVNGZipDirectory> tmpDirectory(new RVNGZipDirectory());
+		if (RVNGZipStream::isZipFile(this) && tmpDirectory->load(this))
+		{
+			m_structureType = Zip;
+			m_streamNameList = tmpDirectory->getSubStreamNamesList();
+			m_zipDirectory = std::move(tmpDirectory);
+			return true;
+		}
+		m_structureType = Flat;
+		return false;
+	}
+	return m_structureType != Flat;
+}
+
+unsigned librevenge::RVNGOLEInputStream::subStreamCount()
+{
+	if (!isStructured()) return 0;
+	return (unsigned) m_streamNameList.size();
+}
+
+const char *librevenge::RVNGOLEInputStream::subStreamName(unsigned id)
+{
+	if (!isStructured() || id >= (unsigned) m_streamNameList.size())
+		return nullptr;
+	return m_streamNameList[size_t(id)].c_str();
+}
+
+bool librevenge::RVNGOLEInputStream::existsSubStream(const char *name)
+{
+	if (!name || !isStructured())
+		return false;
+	for (const auto &i : m_streamNameList)
+	{
+		if (i == name)
+			return true;
+	}
+	return false;
+}
+
+librevenge::RVNGInputStream *librevenge::RVNGOLEInputStream::getSubStreamById(unsigned id)
+{
+	return getSubStreamByName(subStreamName(id));
+}
+
+librevenge::RVNGInputStream *librevenge::RVNGOLEInputStream::getSubStreamByName(const char *name)
+{
+	return getSubStream(name, false);
+}
+
+librevenge::RVNGInputStream *librevenge::RVNGOLEInputStream::getOnDemandSubStreamByName(const char *name)
+{
+	return getSubStream(name, true);
+}
+
+librevenge::RVNGInputStream *librevenge::RVNGOLEInputStream::getSubStream(const char *name, bool onDemand)
+{
+	if (!name || !isStructured())
+		return nullptr;
+	if (m_structureType == OLE2)
+		return m_storage ? m_storage->getSubStream(name, onDemand) : nullptr;
+	if (m_structureType == Zip)
+		return m_zipDirectory ? m_zipDirectory->getSubstream(this, name, onDemand) : nullptr;
+	return nullptr;
+}
+
 // =========== Storage ==========
 
 librevenge::Storage::Storage(RVNGInputStream *is) :
@@ -1764,6 +2185,61 @@ bool librevenge::Storage::isStructured()
 	return m_io->isStructured();
 }
 
+librevenge::RVNGInputStream *librevenge::Storage::getSubStream(const std::string &name, bool onDemand)
+{
+	IStream tmpStream(m_io.get(), name);
+	if (m_io->m_result != Ok || !tmpStream.size())
+		return nullptr;
+
+	if (tmpStream.m_data.empty() && m_io->use_big_block_for(tmpStream.size()))
+	{
+		// the sectors of a stream written at once are usually consecutive,
+		// in which case a memory-backed storage can simply reference them
+		std::vector<unsigned long> const &blocks = tmpStream.m_blocks;
+		const unsigned long blockSize = m_io->m_bbat.m_blockSize;
+		bool consecutive = !blocks.empty() && blockSize && tmpStream.size() <= blockSize * blocks.size();
+		for (size_t i = 1; consecutive && i < blocks.size(); ++i)
+			consecutive = blocks[i] == blocks[i-1] + 1;
+		if (consecutive)
+		{
+			std::shared_ptr<const unsigned char> slice =
+			    RVNGStreamBuffer::getSlice(m_io->m_input, blockSize * (blocks[0] + 1), tmpStream.size());
+			if (slice)
+				return RVNGStreamBuffer::createStream(slice, tmpStream.size());
+		}
+		if (onDemand)
+		{
+			// the sectors are only read later, so check now that the input
+			// holds all of them: a truncated chain is refused, as below
+			const unsigned long inputLength = getLength(m_io->m_input);
+			const unsigned long size = tmpStream.size();
+			const unsigned long needed = blockSize ? (size + blockSize - 1) / blockSize : 0;
+			if (!needed || needed > blocks.size())
+				return nullptr;
+			for (unsigned long i = 0; i < needed; ++i)
+			{
+				// the sector k starts at (k + 1) * blockSize, after the header
+				const unsigned long bytes = i + 1 < needed ? blockSize : size - blockSize * (needed - 1);
+				if (inputLength < bytes || blocks[size_t(i)] >= (inputLength - bytes) / blockSize)
+					return nullptr;
+			}
+			return new RVNGOLEInputStream(m_io.get(), blocks, size);
+		}
+	}
+
+	// the other streams are read at once
+	std::vector<unsigned char> buf(tmpStream.size());
+	unsigned long tmpLength = tmpStream.read(buf.data(), tmpStream.size());
+
+	// sanity check
+	if (tmpLength != tmpStream.size())
+		/* something went wrong here and we do not trust the
+		   resulting buffer */
+		return nullptr;
+
+	return RVNGStreamBuffer::createStream(std::move(buf));
+}
+
 std::vector<std::string> librevenge::Storage::getSubStreamNamesList()
 {
 	std::vector<std::string> res=m_io->getSubStreamNamesList();
@@ -79,6 +79,14 @@ public:
 	 **/
 	Result result();
 
+	/**
+	 * Creates an input stream for the substream \a name, or returns 0 if
+	 * it does not exist. If \a onDemand is true, big substreams are read
+	 * on demand, so the result must not outlive this storage and its
+	 * input stream.
+	 **/
+	RVNGInputStream *getSubStream(const std::string &name, bool onDemand = false);
+
 private:
 	std::unique_ptr<IStorage> m_io;
 
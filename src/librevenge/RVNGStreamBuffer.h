@@ -0,0 +1,58 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* librevenge
+ * Version: MPL 2.0 / LGPLv2.1+
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For minor contributions see the git repository.
+ *
+ * Alternatively, the contents of this file may be used under the terms
+ * of the GNU Lesser General Public License Version 2.1 or later
+ * (LGPLv2.1+), in which case the provisions of the LGPLv2.1+ are
+ * applicable instead of those above.
+ */
+
+#ifndef RVNGSTREAMBUFFER_H
+#define RVNGSTREAMBUFFER_H
+
+#include <memory>
+#include <vector>
+
+namespace librevenge
+{
+
+class RVNGInputStream;
+
+/** Gives access to the data of the streams which keep their whole content in memory.
+
+	It lets the OLE2 and zip readers create substreams which reference
+	the data of their parent instead of copying them. It is private to
+	librevenge, so that the public headers do not depend on the STL.
+ */
+class RVNGStreamBuffer
+{
+public:
+	/** returns a reference to the length bytes of input starting at offset.
+
+		The returned pointer shares the ownership of the parent data, so it
+		stays valid after input is destroyed. It is empty if input does not
+		keep its content in memory or if the range is not inside input.
+	 */
+	static std::shared_ptr<const unsigned char> getSlice(RVNGInputStream *input, unsigned long offset, unsigned long length);
+	/** creates a string stream taking over the content of data, without copying it. */
+	static RVNGInputStream *createStream(std::vector<unsigned char> &&data);
+	/** creates a string stream reading the dataSize bytes starting at data.
+
+		The stream shares the ownership of the buffer data points into, so
+		the buffer must not be modified while the stream is alive. An
+		aliasing std::shared_ptr can reference a slice of a bigger buffer.
+	 */
+	static RVNGInputStream *createStream(const std::shared_ptr<const unsigned char> &data, unsigned long dataSize);
+};
+
+}
+
+#endif // RVNGSTREAMBUFFER_H
+/* vim:set shiftwidth=4 softtabstop=4 noexpandtab: */
@@ -20,16 +20,30 @@
 
 #include <librevenge-stream/librevenge-stream.h>
 
+#include <condition_variable>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include <errno.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #include "RVNGOLEStream.h"
+#include "RVNGStreamBuffer.h"
 #include "RVNGZipStream.h"
 
 #ifndef S_ISREG
@@ -41,65 +55,430 @@ namespace librevenge
 
 enum RVNGStreamType { UNKNOWN, FLAT, OLE2, ZIP };
 
+/** Reads the windows of a file in a background thread.
+
+	Only one window is read ahead: while the stream uses the current
+	one, the next one is being read, so parsing overlaps with I/O.
+ */
+class RVNGFileReadAhead
+{
+public:
+	RVNGFileReadAhead(const RVNGInputStream *input, unsigned long windowSize);
+	~RVNGFileReadAhead();
+
+	unsigned long windowSize() const
+	{
+		return m_windowSize;
+	}
+	//! starts reading the window beginning at pos, unless the current window already contains pos
+	void request(unsigned long pos);
+	/** returns the window containing the numBytes bytes at pos, waiting for it if needed.
+
+		The caller owns the returned buffer, which begins at start. Returns
+		0, keeping the window, if the window does not contain these bytes.
+	 */
+	unsigned char *take(unsigned long pos, unsigned long numBytes, unsigned long &start, unsigned long &length);
+	//! gives back a buffer returned by take, so that it can be reused
+	void recycle(unsigned char *buffer);
+
+private:
+	void run();
+
+	const RVNGInputStream *m_input;
+	const unsigned long m_windowSize;
+	std::thread m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	bool m_stop;
+	//! true if the window at m_pos is requested, but not read yet
+	bool m_pending;
+	//! true if m_buffer contains the window at m_pos
+	bool m_ready;
+	unsigned long m_pos;
+	unsigned long m_length;
+	std::unique_ptr<unsigned char[]> m_buffer;
+	std::unique_ptr<unsigned char[]> m_spare;
+
+	// no copy or assign
+	RVNGFileReadAhead(const RVNGFileReadAhead &);
+	RVNGFileReadAhead &operator=(const RVNGFileReadAhead &);
+};
+
 class RVNGFileStreamPrivate
 {
 public:
 	RVNGFileStreamPrivate();
 	~RVNGFileStreamPrivate();
+	//! frees the read buffer, giving it back to the read-ahead if it comes from there
+	void freeReadBuffer();
+	//! the name of the file, kept to open clones
+	std::string fileName;
 	FILE *file;
+#ifdef _WIN32
+	//! the handle used by readAt, whose file position does not matter
+	HANDLE positionalFile;
+#endif
 	unsigned long streamSize;
 	unsigned char *readBuffer;
 	unsigned long readBufferLength;
 	unsigned long readBufferPos;
+	//! the background reader, when read-ahead is enabled
+	std::unique_ptr<RVNGFileReadAhead> readAhead;
+	//! true if readBuffer was read by readAhead
+	bool readBufferFromReadAhead;
+	//! the beginning and the end of the last read buffer, to detect sequential reads
+	unsigned long lastReadBufferStart;
+	unsigned long lastReadBufferEnd;
 	RVNGStreamType streamType;
 	std::vector<std::string> streamNameList;
+	//! the parsed OLE2 storage, kept to open the substreams
+	std::unique_ptr<Storage> storage;
+	//! the zip central directory, kept to open the substreams
+	std::unique_ptr<RVNGZipDirectory> zipDirectory;
 private:
 	RVNGFileStreamPrivate(const RVNGFileStreamPrivate &);
 	RVNGFileStreamPrivate &operator=(const RVNGFileStreamPrivate &);
 };
 
+class RVNGMappedFileStreamPrivate
+{
+public:
+	RVNGMappedFileStreamPrivate();
+	~RVNGMappedFileStreamPrivate();
+	bool map(const char *filename);
+	const unsigned char *data;
+	//! owns the mapping, which can be shared with the substreams
+	std::shared_ptr<const unsigned char> mapping;
+	size_t mappedSize;
+	unsigned long streamSize;
+	long offset;
+	RVNGStreamType streamType;
+	std::vector<std::string> streamNameList;
+	//! the parsed OLE2 storage, kept to open the substreams
+	std::unique_ptr<Storage> storage;
+	//! the zip central directory, kept to open the substreams
+	std::unique_ptr<RVNGZipDirectory> zipDirectory;
+private:
+	RVNGMappedFileStreamPrivate(const RVNGMappedFileStreamPrivate &);
+	RVNGMappedFileStreamPrivate &operator=(const RVNGMappedFileStreamPrivate &);
+};
+
 class RVNGStringStreamPrivate
 {
 public:
-	RVNGStringStreamPrivate(const unsigned char *data, unsigned dataSize);
+	RVNGStringStreamPrivate(const std::shared_ptr<const unsigned char> &data, unsigned long dataSize);
 	~RVNGStringStreamPrivate();
-	std::vector<unsigned char> buffer;
-	volatile long offset;
+	//! the data, possibly shared with other streams
+	std::shared_ptr<const unsigned char> buffer;
+	unsigned long bufferSize;
+	long offset;
 	RVNGStreamType streamType;
 	std::vector<std::string> streamNameList;
+	//! the parsed OLE2 storage, kept to open the substreams
+	std::unique_ptr<Storage> storage;
+	//! the zip central directory, kept to open the substreams
+	std::unique_ptr<RVNGZipDirectory> zipDirectory;
 private:
 	RVNGStringStreamPrivate(const RVNGStringStreamPrivate &);
 	RVNGStringStreamPrivate &operator=(const RVNGStringStreamPrivate &);
 };
 
+namespace
+{
+
+//! unmaps a file when the last reference to its mapping goes
+struct MappingDeleter
+{
+	explicit MappingDeleter(size_t size) : m_size(size) {}
+	void operator()(const unsigned char *data) const
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(data);
+#else
+		munmap(const_cast<unsigned char *>(data), m_size);
+#endif
+	}
+	size_t m_size;
+};
+
+//! returns a shared pointer taking over the data
+std::shared_ptr<const unsigned char> makeSharedBuffer(std::vector<unsigned char> &&data)
+{
+	std::shared_ptr<std::vector<unsigned char> > owner = std::make_shared<std::vector<unsigned char> >(std::move(data));
+	return std::shared_ptr<const unsigned char>(owner, owner->data());
+}
+
+//! calls the release function given with the data of a string stream
+struct ReleaseDeleter
+{
+	ReleaseDeleter(void (*release)(void *), void *owner) : m_release(release), m_owner(owner) {}
+	void operator()(const unsigned char *) const
+	{
+		if (m_release)
+			m_release(m_owner);
+	}
+	void (*m_release)(void *);
+	void *m_owner;
+};
+
+void releaseVector(void *owner)
+{
+	delete static_cast<std::vector<unsigned char> *>(owner);
+}
+
+void releaseSharedBuffer(void *owner)
+{
+	delete static_cast<std::shared_ptr<const unsigned char> *>(owner);
+}
+
+//! creates the substream name of a structured stream, reading it on demand if asked
+RVNGInputStream *getStructuredSubStream(RVNGInputStream *input, RVNGStreamType streamType, Storage *storage,
+                                        RVNGZipDirectory *zipDirectory, const char *name, bool onDemand)
+{
+	if (streamType == OLE2)
+		return storage ? storage->getSubStream(name, onDemand) : nullptr;
+	else if (streamType == ZIP)
+		return zipDirectory ? zipDirectory->getSubstream(input, name, onDemand) : nullptr;
+	return nullptr;
+}
+
+}
+
 RVNGFileStreamPrivate::RVNGFileStreamPrivate() :
+	fileName(),
 	file(nullptr),
+#ifdef _WIN32
+	positionalFile(INVALID_HANDLE_VALUE),
+#endif
 	streamSize(0),
 	readBuffer(nullptr),
 	readBufferLength(0),
 	readBufferPos(0),
+	readAhead(),
+	readBufferFromReadAhead(false),
+	lastReadBufferStart(0),
+	lastReadBufferEnd(0),
 	streamType(UNKNOWN),
-	streamNameList()
+	streamNameList(),
+	storage(),
+	zipDirectory()
 {
 }
 
 RVNGFileStreamPrivate::~RVNGFileStreamPrivate()
 {
+	// the background reader uses the file, so stop it first
+	readAhead.reset();
 	if (file)
 		fclose(file);
+#ifdef _WIN32
+	if (positionalFile != INVALID_HANDLE_VALUE)
+		CloseHandle(positionalFile);
+#endif
 	if (readBuffer)
 		delete [] readBuffer;
 }
 
-RVNGStringStreamPrivate::RVNGStringStreamPrivate(const unsigned char *data, unsigned dataSize) :
-	buffer(dataSize),
+void RVNGFileStreamPrivate::freeReadBuffer()
+{
+	if (readBuffer && readBufferFromReadAhead && readAhead)
+		readAhead->recycle(readBuffer);
+	else if (readBuffer)
+		delete [] readBuffer;
+	readBuffer = nullptr;
+	readBufferFromReadAhead = false;
+}
+
+RVNGFileReadAhead::RVNGFileReadAhead(const RVNGInputStream *input, unsigned long windowSize) :
+	m_input(input),
+	m_windowSize(windowSize),
+	m_thread(),
+	m_mutex(),
+	m_condition(),
+	m_stop(false),
+	m_pending(false),
+	m_ready(false),
+	m_pos(0),
+	m_length(0),
+	m_buffer(),
+	m_spare()
+{
+}
+
+RVNGFileReadAhead::~RVNGFileReadAhead()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_condition.notify_all();
+	if (m_thread.joinable())
+		m_thread.join();
+}
+
+void RVNGFileReadAhead::request(unsigned long pos)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (pos >= m_pos && ((m_pending && pos < m_pos + m_windowSize) || (m_ready && pos < m_pos + m_length)))
+			return;
+		if (m_ready)
+		{
+			m_spare = std::move(m_buffer);
+			m_ready = false;
+		}
+		m_pos = pos;
+		m_pending = true;
+		if (!m_thread.joinable())
+			m_thread = std::thread(&RVNGFileReadAhead::run, this);
+	}
+	m_condition.notify_all();
+}
+
+unsigned char *RVNGFileReadAhead::take(unsigned long pos, unsigned long numBytes, unsigned long &start, unsigned long &length)
+{
+	start = 0;
+	length = 0;
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (pos < m_pos || pos - m_pos + numBytes > m_windowSize || !(m_pending || m_ready))
+		return nullptr;
+	m_condition.wait(lock, [this] { return !m_pending || m_stop; });
+	if (!m_ready || pos - m_pos + numBytes > m_length)
+		return nullptr;
+	m_ready = false;
+	start = m_pos;
+	length = m_length;
+	return m_buffer.release();
+}
+
+void RVNGFileReadAhead::recycle(unsigned char *buffer)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (!m_spare)
+		m_spare.reset(buffer);
+	else
+		delete [] buffer;
+}
+
+void RVNGFileReadAhead::run()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		m_condition.wait(lock, [this] { return m_pending || m_stop; });
+		if (m_stop)
+			return;
+		const unsigned long pos = m_pos;
+		std::unique_ptr<unsigned char[]> buffer(std::move(m_spare));
+		lock.unlock();
+		if (!buffer)
+			buffer.reset(new unsigned char[m_windowSize]);
+		const unsigned long length = m_input->readAt(pos, m_windowSize, buffer.get());
+		lock.lock();
+		if (pos != m_pos)
+		{
+			// another window was requested meanwhile
+			m_spare = std::move(buffer);
+			continue;
+		}
+		m_buffer = std::move(buffer);
+		m_length = length;
+		m_pending = false;
+		m_ready = true;
+		m_condition.notify_all();
+	}
+}
+
+RVNGMappedFileStreamPrivate::RVNGMappedFileStreamPrivate() :
+	data(nullptr),
+	mapping(),
+	mappedSize(0),
+	streamSize(0),
 	offset(0),
 	streamType(UNKNOWN),
-	streamNameList()
+	streamNameList(),
+	storage(),
+	zipDirectory()
+{
+}
 
+RVNGMappedFileStreamPrivate::~RVNGMappedFileStreamPrivate()
 {
-	if (dataSize != 0)
-		memcpy(buffer.data(), data, dataSize);
+}
+
+bool RVNGMappedFileStreamPrivate::map(const char *filename)
+{
+	struct stat status;
+	const int retval = stat(filename, &status);
+	if ((0 != retval) || !S_ISREG(status.st_mode))
+		return false;
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || (unsigned long long) size.QuadPart > (unsigned long long)(std::numeric_limits<size_t>::max)())
+	{
+		CloseHandle(file);
+		return false;
+	}
+	mappedSize = (size_t) size.QuadPart;
+	if (mappedSize)
+	{
+		// the view keeps references to the mapping and to the file, so the handles can go
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping)
+		{
+			data = static_cast<const unsigned char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			CloseHandle(mapping);
+		}
+	}
+	CloseHandle(file);
+#else
+	int fd = open(filename, O_RDONLY);
+	if (fd == -1)
+		return false;
+	struct stat fdStatus;
+	if (fstat(fd, &fdStatus) != 0 || (unsigned long long) fdStatus.st_size > (unsigned long long)(std::numeric_limits<size_t>::max)())
+	{
+		close(fd);
+		return false;
+	}
+	mappedSize = (size_t) fdStatus.st_size;
+	if (mappedSize)
+	{
+		void *mapped = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped != MAP_FAILED)
+			data = static_cast<const unsigned char *>(mapped);
+	}
+	close(fd);
+#endif
+	if (mappedSize && !data)
+		return false;
+	if (data)
+		mapping.reset(data, MappingDeleter(mappedSize));
+
+	// preventing possible unsigned/signed issues later by truncating the file
+	streamSize = (unsigned long) mappedSize;
+	if (mappedSize > (std::numeric_limits<unsigned long>::max)() / 2)
+		streamSize = (std::numeric_limits<unsigned long>::max)() / 2;
+	return true;
+}
+
+RVNGStringStreamPrivate::RVNGStringStreamPrivate(const std::shared_ptr<const unsigned char> &data, unsigned long dataSize) :
+	buffer(data),
+	bufferSize(data ? dataSize : 0),
+	offset(0),
+	streamType(UNKNOWN),
+	streamNameList(),
+	storage(),
+	zipDirectory()
+
+{
+	// preventing possible unsigned/signed issues later by truncating the data
+	if (bufferSize > (std::numeric_limits<unsigned long>::max)() / 2)
+		bufferSize = (std::numeric_limits<unsigned long>::max)() / 2;
 }
 
 RVNGStringStreamPrivate::~RVNGStringStreamPrivate()
@@ -117,6 +496,10 @@ RVNGFileStream::RVNGFileStream(const char *filename) :
 		d = nullptr;
 		return;
 	}
+	d->fileName = filename;
+#ifdef _WIN32
+	d->positionalFile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+#endif
 
 	struct stat status;
 	const int retval = stat(filename, &status);
@@ -171,8 +554,7 @@ const unsigned char *RVNGFileStream::read(unsigned long numBytes, unsigned long
 	{
 		fseek(d->file, (long)ftell(d->file) - (long)d->readBufferLength, SEEK_SET);
 		fseek(d->file, (long)d->readBufferPos, SEEK_CUR);
-		delete [] d->readBuffer;
-		d->readBuffer = nullptr;
+		d->freeReadBuffer();
 		d->readBufferPos = 0;
 		d->readBufferLength = 0;
 	}
@@ -190,6 +572,28 @@ const unsigned char *RVNGFileStream::read(unsigned long numBytes, unsigned long
 	if (numBytes == 0)
 		return nullptr;
 
+	// use the window read in the background, if it contains what we need
+	if (d->readAhead && numBytes <= d->readAhead->windowSize())
+	{
+		unsigned long windowStart = 0;
+		unsigned long windowLength = 0;
+		unsigned char *window = d->readAhead->take(curpos, numBytes, windowStart, windowLength);
+		if (window)
+		{
+			fseek(d->file, (long)(windowStart + windowLength), SEEK_SET);
+			d->readBuffer = window;
+			d->readBufferFromReadAhead = true;
+			d->readBufferLength = windowLength;
+			d->readBufferPos = curpos - windowStart + numBytes;
+			d->lastReadBufferStart = windowStart;
+			d->lastReadBufferEnd = windowStart + windowLength;
+			if (d->lastReadBufferEnd < d->streamSize)
+				d->readAhead->request(d->lastReadBufferEnd);
+			numBytesRead = numBytes;
+			return const_cast<const unsigned char *>(d->readBuffer + (curpos - windowStart));
+		}
+	}
+
 	if (numBytes < BUFFER_MAX)
 	{
 		if (BUFFER_MAX < d->streamSize - curpos)
@@ -212,6 +616,14 @@ const unsigned char *RVNGFileStream::read(unsigned long numBytes, unsigned long
 	if (!d->readBufferLength)
 		return nullptr;
 
+	// the reads are sequential if this one starts in or just after the
+	// last buffer, so start reading the next window
+	if (d->readAhead && curpos >= d->lastReadBufferStart && curpos <= d->lastReadBufferEnd
+	        && curpos + d->readBufferLength < d->streamSize)
+		d->readAhead->request(curpos + d->readBufferLength);
+	d->lastReadBufferStart = curpos;
+	d->lastReadBufferEnd = curpos + d->readBufferLength;
+
 	numBytesRead = numBytes;
 
 	d->readBufferPos += numBytesRead;
@@ -249,8 +661,7 @@ int RVNGFileStream::seek(long offset, RVNG_SEEK_TYPE seekType)
 	{
 		fseek(d->file, (long)ftell(d->file) - (long)d->readBufferLength, SEEK_SET);
 		fseek(d->file, (long) d->readBufferPos, SEEK_CUR);
-		delete [] d->readBuffer;
-		d->readBuffer = nullptr;
+		d->freeReadBuffer();
 		d->readBufferPos = 0;
 		d->readBufferLength = 0;
 	}
@@ -271,6 +682,66 @@ bool RVNGFileStream::isEnd()
 	return (tell() >= (long)d->streamSize);
 }
 
+unsigned long RVNGFileStream::readAt(unsigned long offset, unsigned long numBytes, unsigned char *buffer) const
+{
+	if (!d || !buffer || offset >= d->streamSize)
+		return 0;
+	if (numBytes > d->streamSize - offset)
+		numBytes = d->streamSize - offset;
+
+	unsigned long bytes = 0;
+	while (bytes < numBytes)
+	{
+#ifdef _WIN32
+		if (d->positionalFile == INVALID_HANDLE_VALUE)
+			break;
+		const unsigned long long pos = (unsigned long long) offset + bytes;
+		OVERLAPPED overlapped = OVERLAPPED();
+		overlapped.Offset = DWORD(pos & 0xffffffff);
+		overlapped.OffsetHigh = DWORD(pos >> 32);
+		DWORD numBytesRead = 0;
+		if (!ReadFile(d->positionalFile, buffer + bytes, DWORD(numBytes - bytes), &numBytesRead, &overlapped) || !numBytesRead)
+			break;
+#else
+		const ssize_t numBytesRead = pread(fileno(d->file), buffer + bytes, size_t(numBytes - bytes), off_t(offset + bytes));
+		if (numBytesRead < 0 && errno == EINTR)
+			continue;
+		if (numBytesRead <= 0)
+			break;
+#endif
+		bytes += (unsigned long) numBytesRead;
+	}
+	return bytes;
+}
+
+RVNGInputStream *RVNGFileStream::clone() const
+{
+	if (!d)
+		return nullptr;
+	std::unique_ptr<RVNGFileStream> stream(new RVNGFileStream(d->fileName.c_str()));
+	if (!stream->d)
+		return nullptr;
+	return stream.release();
+}
+
+#define READ_AHEAD_WINDOW (1 << 20)
+
+void RVNGFileStream::setReadAhead(bool readAhead)
+{
+	if (!d || readAhead == bool(d->readAhead))
+		return;
+	if (!readAhead)
+	{
+		// the buffer can not be given back anymore, but it is still valid
+		d->readBufferFromReadAhead = false;
+		d->readAhead.reset();
+		return;
+	}
+	d->readAhead.reset(new RVNGFileReadAhead(this, READ_AHEAD_WINDOW));
+	d->lastReadBufferStart = (unsigned long) tell();
+	d->lastReadBufferEnd = d->lastReadBufferStart;
+}
+
 bool RVNGFileStream::isStructured()
 {
 	if (!d)
@@ -282,19 +753,22 @@ bool RVNGFileStream::isStructured()
 		seek(0, RVNG_SEEK_SET);
 
 		// Check whether it is OLE2 storage
-		Storage tmpStorage(this);
-		if (tmpStorage.isStructured())
+		std::unique_ptr<Storage> tmpStorage(new Storage(this));
+		if (tmpStorage->isStructured())
 		{
 			d->streamType = OLE2;
-			d->streamNameList = tmpStorage.getSubStreamNamesList();
+			d->streamNameList = tmpStorage->getSubStreamNamesList();
+			d->storage = std::move(tmpStorage);
 			seek(0, RVNG_SEEK_SET);
 			return true;
 		}
 		seek(0, RVNG_SEEK_SET);
-		if (RVNGZipStream::isZipFile(this))
+		std::unique_ptr<RVNGZipDirectory> tmpDirectory(new RVNGZipDirectory());
+		if (RVNGZipStream::isZipFile(this) && tmpDirectory->load(this))
 		{
 			d->streamType = ZIP;
-			d->streamNameList = RVNGZipStream::getSubStreamNamesList(this);
+			d->streamNameList = tmpDirectory->getSubStreamNamesList();
+			d->zipDirectory = std::move(tmpDirectory);
 			seek(0, RVNG_SEEK_SET);
 			return true;
 		}
@@ -351,37 +825,216 @@ RVNGInputStream *RVNGFileStream::getSubStreamByName(const char *name)
 		return nullptr;
 	if (d->streamType == UNKNOWN && !isStructured())
 		return nullptr;
-	if (d->streamType == OLE2)
+	return getStructuredSubStream(this, d->streamType, d->storage.get(), d->zipDirectory.get(), name, false);
+}
+
+RVNGInputStream *RVNGFileStream::getOnDemandSubStreamByName(const char *name)
+{
+	if (!name || !d)
+		return nullptr;
+	if (ferror(d->file))
+		return nullptr;
+	if (d->streamType == UNKNOWN && !isStructured())
+		return nullptr;
+	return getStructuredSubStream(this, d->streamType, d->storage.get(), d->zipDirectory.get(), name, true);
+}
+
+RVNGMappedFileStream::RVNGMappedFileStream(const char *filename) :
+	RVNGInputStream(),
+	d(new RVNGMappedFileStreamPrivate())
+{
+	if (!filename || !d->map(filename))
 	{
-		seek(0, RVNG_SEEK_SET);
-		Storage tmpStorage(this);
-		Stream tmpStream(&tmpStorage, name);
-		if (tmpStorage.result() != Storage::Ok  || !tmpStream.size())
-			return (RVNGInputStream *)nullptr;
+		delete d;
+		d = nullptr;
+	}
+}
 
-		std::vector<unsigned char> buf(tmpStream.size());
-		unsigned long tmpLength;
-		tmpLength = tmpStream.read(buf.data(), tmpStream.size());
+RVNGMappedFileStream::~RVNGMappedFileStream()
+{
+	delete d;
+}
 
-		// sanity check
-		if (tmpLength != tmpStream.size())
-			/* something went wrong here and we do not trust the
-			   resulting buffer */
-			return (RVNGInputStream *)nullptr;
+const unsigned char *RVNGMappedFileStream::read(unsigned long numBytes, unsigned long &numBytesRead)
+{
+	numBytesRead = 0;
 
-		return new RVNGStringStream(buf.data(), (unsigned)tmpLength);
-	}
-	else if (d->streamType == ZIP)
+	if (!d || numBytes == 0)
+		return nullptr;
+
+	unsigned long numBytesToRead = d->streamSize - (unsigned long) d->offset;
+	if (numBytes < numBytesToRead)
+		numBytesToRead = numBytes;
+	if (numBytesToRead == 0)
+		return nullptr;
+
+	const unsigned char *pTmp = d->data + d->offset;
+	d->offset += (long) numBytesToRead;
+	numBytesRead = numBytesToRead;
+	return pTmp;
+}
+
+long RVNGMappedFileStream::tell()
+{
+	if (!d)
+		return -1L;
+	return d->offset;
+}
+
+int RVNGMappedFileStream::seek(long offset, RVNG_SEEK_TYPE seekType)
+{
+	if (!d)
+		return -1;
+	if (seekType == RVNG_SEEK_CUR)
+		offset += d->offset;
+	if (seekType == RVNG_SEEK_END)
+		offset += (long)d->streamSize;
+
+	if (offset < 0)
+		offset = 0;
+	if (offset > (long)d->streamSize)
+		offset = (long)d->streamSize;
+
+	d->offset = offset;
+	return 0;
+}
+
+bool RVNGMappedFileStream::isEnd()
+{
+	if (!d)
+		return true;
+	return ((unsigned long) d->offset >= d->streamSize);
+}
+
+unsigned long RVNGMappedFileStream::readAt(unsigned long offset, unsigned long numBytes, unsigned char *buffer) const
+{
+	if (!d || !buffer || offset >= d->streamSize)
+		return 0;
+	if (numBytes > d->streamSize - offset)
+		numBytes = d->streamSize - offset;
+	memcpy(buffer, d->data + offset, numBytes);
+	return numBytes;
+}
+
+RVNGInputStream *RVNGMappedFileStream::clone() const
+{
+	if (!d)
+		return nullptr;
+	// a stream sharing the mapping, which keeps it alive
+	return RVNGStreamBuffer::createStream(d->mapping, d->streamSize);
+}
+
+bool RVNGMappedFileStream::isStructured()
+{
+	if (!d)
+		return false;
+	if (d->streamType == UNKNOWN)
 	{
 		seek(0, RVNG_SEEK_SET);
-		return RVNGZipStream::getSubstream(this, name);
+
+		// Check whether it is OLE2 storage
+		std::unique_ptr<Storage> tmpStorage(new Storage(this));
+		if (tmpStorage->isStructured())
+		{
+			d->streamType = OLE2;
+			d->streamNameList = tmpStorage->getSubStreamNamesList();
+			d->storage = std::move(tmpStorage);
+			seek(0, RVNG_SEEK_SET);
+			return true;
+		}
+		seek(0, RVNG_SEEK_SET);
+		std::unique_ptr<RVNGZipDirectory> tmpDirectory(new RVNGZipDirectory());
+		if (RVNGZipStream::isZipFile(this) && tmpDirectory->load(this))
+		{
+			d->streamType = ZIP;
+			d->streamNameList = tmpDirectory->getSubStreamNamesList();
+			d->zipDirectory = std::move(tmpDirectory);
+			seek(0, RVNG_SEEK_SET);
+			return true;
+		}
+		d->streamType = FLAT;
+		return false;
 	}
-	return nullptr;
+	else if (d->streamType == FLAT)
+		return false;
+	else
+		return true;
+}
+
+unsigned RVNGMappedFileStream::subStreamCount()
+{
+	if (!isStructured()||!d) return 0;
+	return (unsigned) d->streamNameList.size();
+}
+
+const char *RVNGMappedFileStream::subStreamName(unsigned id)
+{
+	if (!isStructured() ||!d || id>=(unsigned) d->streamNameList.size())
+		return nullptr;
+	return d->streamNameList[size_t(id)].c_str();
+}
+
+bool RVNGMappedFileStream::existsSubStream(const char *name)
+{
+	if (!name || !d)
+		return false;
+	if (d->streamType == UNKNOWN && !isStructured())
+		return false;
+	if (d->streamType == FLAT)
+		return false;
+	for (const auto &i : d->streamNameList)
+	{
+		if (i == name)
+			return true;
+	}
+	return false;
+}
+
+RVNGInputStream *RVNGMappedFileStream::getSubStreamById(unsigned id)
+{
+	return getSubStreamByName(subStreamName(id));
+}
+
+RVNGInputStream *RVNGMappedFileStream::getSubStreamByName(const char *name)
+{
+	if (!name || !d)
+		return nullptr;
+	if (d->streamType == UNKNOWN && !isStructured())
+		return nullptr;
+	return getStructuredSubStream(this, d->streamType, d->storage.get(), d->zipDirectory.get(), name, false);
+}
+
+RVNGInputStream *RVNGMappedFileStream::getOnDemandSubStreamByName(const char *name)
+{
+	if (!name || !d)
+		return nullptr;
+	if (d->streamType == UNKNOWN && !isStructured())
+		return nullptr;
+	return getStructuredSubStream(this, d->streamType, d->storage.get(), d->zipDirectory.get(), name, true);
 }
 
 RVNGStringStream::RVNGStringStream(const unsigned char *data, const unsigned int dataSize) :
 	RVNGInputStream(),
-	d(new RVNGStringStreamPrivate(data, dataSize))
+	d(nullptr)
+{
+	std::vector<unsigned char> buffer;
+	if (data && dataSize)
+		buffer.assign(data, data + dataSize);
+	d = new RVNGStringStreamPrivate(makeSharedBuffer(std::move(buffer)), dataSize);
+}
+
+RVNGStringStream::RVNGStringStream(const unsigned char *data, unsigned long dataSize, void (*release)(void *), void *owner) :
+	RVNGInputStream(),
+	d(nullptr)
+{
+	// the deleter is also called for a null pointer, so release always comes once
+	const std::shared_ptr<const unsigned char> buffer(data, ReleaseDeleter(release, owner));
+	d = new RVNGStringStreamPrivate(buffer, data ? dataSize : 0);
+}
+
+RVNGStringStream::RVNGStringStream(RVNGStringStreamPrivate *data) :
+	RVNGInputStream(),
+	d(data)
 {
 }
 
@@ -399,10 +1052,10 @@ const unsigned char *RVNGStringStream::read(unsigned long numBytes, unsigned lon
 
 	long numBytesToRead;
 
-	if ((unsigned long)d->offset+numBytes < d->buffer.size())
+	if ((unsigned long)d->offset+numBytes < d->bufferSize)
 		numBytesToRead = (long) numBytes;
 	else
-		numBytesToRead = (long) d->buffer.size() - d->offset;
+		numBytesToRead = (long) d->bufferSize - d->offset;
 
 	numBytesRead = (unsigned long) numBytesToRead; // about as paranoid as we can be..
 
@@ -412,7 +1065,7 @@ const unsigned char *RVNGStringStream::read(unsigned long numBytes, unsigned lon
 	long oldOffset = d->offset;
 	d->offset += numBytesToRead;
 
-	return &d->buffer[size_t(oldOffset)];
+	return d->buffer.get() + oldOffset;
 
 }
 
@@ -428,16 +1081,16 @@ int RVNGStringStream::seek(long offset, RVNG_SEEK_TYPE seekType)
 	else if (seekType == RVNG_SEEK_SET)
 		d->offset = offset;
 	else if (seekType == RVNG_SEEK_END)
-		d->offset = offset+(long) d->buffer.size();
+		d->offset = offset+(long) d->bufferSize;
 
 	if (d->offset < 0)
 	{
 		d->offset = 0;
 		return -1;
 	}
-	if ((long)d->offset > (long)d->buffer.size())
+	if ((long)d->offset > (long)d->bufferSize)
 	{
-		d->offset = (long) d->buffer.size();
+		d->offset = (long) d->bufferSize;
 		return -1;
 	}
 
@@ -446,15 +1099,30 @@ int RVNGStringStream::seek(long offset, RVNG_SEEK_TYPE seekType)
 
 bool RVNGStringStream::isEnd()
 {
-	if ((long)d->offset >= (long)d->buffer.size())
+	if ((long)d->offset >= (long)d->bufferSize)
 		return true;
 
 	return false;
 }
 
+unsigned long RVNGStringStream::readAt(unsigned long offset, unsigned long numBytes, unsigned char *buffer) const
+{
+	if (!buffer || offset >= d->bufferSize)
+		return 0;
+	if (numBytes > d->bufferSize - offset)
+		numBytes = d->bufferSize - offset;
+	memcpy(buffer, d->buffer.get() + offset, numBytes);
+	return numBytes;
+}
+
+RVNGInputStream *RVNGStringStream::clone() const
+{
+	return new RVNGStringStream(new RVNGStringStreamPrivate(d->buffer, d->bufferSize));
+}
+
 bool RVNGStringStream::isStructured()
 {
-	if (d->buffer.empty())
+	if (!d->bufferSize)
 		return false;
 
 	if (d->streamType == UNKNOWN)
@@ -462,18 +1130,21 @@ bool RVNGStringStream::isStructured()
 		seek(0, RVNG_SEEK_SET);
 
 		// Check whether it is OLE2 storage
-		Storage tmpStorage(this);
-		if (tmpStorage.isStructured())
+		std::unique_ptr<Storage> tmpStorage(new Storage(this));
+		if (tmpStorage->isStructured())
 		{
 			d->streamType = OLE2;
-			d->streamNameList = tmpStorage.getSubStreamNamesList();
+			d->streamNameList = tmpStorage->getSubStreamNamesList();
+			d->storage = std::move(tmpStorage);
 			return true;
 		}
 		seek(0, RVNG_SEEK_SET);
-		if (RVNGZipStream::isZipFile(this))
+		std::unique_ptr<RVNGZipDirectory> tmpDirectory(new RVNGZipDirectory());
+		if (RVNGZipStream::isZipFile(this) && tmpDirectory->load(this))
 		{
 			d->streamType = ZIP;
-			d->streamNameList = RVNGZipStream::getSubStreamNamesList(this);
+			d->streamNameList = tmpDirectory->getSubStreamNamesList();
+			d->zipDirectory = std::move(tmpDirectory);
 			return true;
 		}
 		d->streamType = FLAT;
@@ -502,7 +1173,7 @@ bool RVNGStringStream::existsSubStream(const char *name)
 {
 	if (!name || !d)
 		return false;
-	if (d->buffer.empty())
+	if (!d->bufferSize)
 		return false;
 	if (d->streamType == UNKNOWN && !isStructured())
 		return false;
@@ -523,34 +1194,54 @@ RVNGInputStream *RVNGStringStream::getSubStreamById(unsigned id)
 
 RVNGInputStream *RVNGStringStream::getSubStreamByName(const char *name)
 {
-	if (!name || d->buffer.empty())
+	if (!name || !d->bufferSize)
+		return nullptr;
+	if (d->streamType == UNKNOWN && !isStructured())
+		return nullptr;
+	return getStructuredSubStream(this, d->streamType, d->storage.get(), d->zipDirectory.get(), name, false);
+}
+
+RVNGInputStream *RVNGStringStream::getOnDemandSubStreamByName(const char *name)
+{
+	if (!name || !d->bufferSize)
 		return nullptr;
 	if (d->streamType == UNKNOWN && !isStructured())
 		return nullptr;
+	return getStructuredSubStream(this, d->streamType, d->storage.get(), d->zipDirectory.get(), name, true);
+}
 
-	if (d->streamType == OLE2)
+std::shared_ptr<const unsigned char> RVNGStreamBuffer::getSlice(RVNGInputStream *input, unsigned long offset, unsigned long length)
+{
+	std::shared_ptr<const unsigned char> data;
+	unsigned long dataSize = 0;
+	if (auto stringStream = dynamic_cast<RVNGStringStream *>(input))
 	{
-		seek(0, RVNG_SEEK_SET);
-		Storage tmpStorage(this);
-		Stream tmpStream(&tmpStorage, name);
-		if (tmpStorage.result() != Storage::Ok  || !tmpStream.size())
-			return (RVNGInputStream *)nullptr;
-
-		std::vector<unsigned char> buf(tmpStream.size());
-		unsigned long tmpLength;
-		tmpLength = tmpStream.read(buf.data(), tmpStream.size());
+		data = stringStream->d->buffer;
+		dataSize = stringStream->d->bufferSize;
+	}
+	else if (auto mappedStream = dynamic_cast<RVNGMappedFileStream *>(input))
+	{
+		if (mappedStream->d)
+		{
+			data = mappedStream->d->mapping;
+			dataSize = mappedStream->d->streamSize;
+		}
+	}
+	if (!data || offset > dataSize || length > dataSize - offset)
+		return std::shared_ptr<const unsigned char>();
+	return std::shared_ptr<const unsigned char>(data, data.get() + offset);
+}
 
-		// sanity check
-		if (tmpLength != tmpStream.size())
-			/* something went wrong here and we do not trust the
-			   resulting buffer */
-			return (RVNGInputStream *)nullptr;
+RVNGInputStream *RVNGStreamBuffer::createStream(std::vector<unsigned char> &&data)
+{
+	auto owner = new std::vector<unsigned char>(std::move(data));
+	return new RVNGStringStream(owner->empty() ? nullptr : owner->data(), (unsigned long) owner->size(), releaseVector, owner);
+}
 
-		return new RVNGStringStream(buf.data(), (unsigned)tmpLength);
-	}
-	else if (d->streamType == ZIP)
-		return RVNGZipStream::getSubstream(this, name);
-	return nullptr;
+RVNGInputStream *RVNGStreamBuffer::createStream(const std::shared_ptr<const unsigned char> &data, unsigned long dataSize)
+{
+	auto owner = new std::shared_ptr<const unsigned char>(data);
+	return new RVNGStringStream(data.get(), dataSize, releaseSharedBuffer, owner);
 }
 
 }
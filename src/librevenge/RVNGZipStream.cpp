@@ -19,16 +19,20 @@
 
 #include "RVNGZipStream.h"
 
-#include <algorithm>
-#include <cassert>
 #include <string>
 #include <string.h>
 #include <stdio.h>
+#include <unordered_map>
 #include <utility>
 
 #include <zlib.h>
 #include <librevenge-stream/librevenge-stream.h>
 
+#include "librevenge_internal.h"
+#include "RVNGInflate.h"
+#include "RVNGOLEStream.h"
+#include "RVNGStreamBuffer.h"
+
 namespace librevenge
 {
 
@@ -343,33 +347,516 @@ static bool findCentralDirectoryEnd(RVNGInputStream *input)
 	return false;
 }
 
-static bool findDataStream(RVNGInputStream *input, CentralDirectoryEntry &entry, const char *name)
+static bool findDataStream(RVNGInputStream *input, CentralDirectoryEntry const &entry)
 {
-	size_t name_size = strlen(name);
-	if (!findCentralDirectoryEnd(input))
+	input->seek(entry.offset, RVNG_SEEK_SET);
+	LocalFileHeader header;
+	if (!readLocalFileHeader(input, header))
 		return false;
-	CentralDirectoryEnd end;
-	if (!readCentralDirectoryEnd(input, end))
+	if (!areHeadersConsistent(header, entry))
 		return false;
-	input->seek(end.cdir_offset, RVNG_SEEK_SET);
-	while (!input->isEnd() && (unsigned)input->tell() < end.cdir_offset + end.cdir_size)
+	return true;
+}
+
+/** An input stream which inflates a deflated zip member on demand.
+
+	Only a bounded window of the uncompressed data is kept in memory. A copy
+	of the inflate state is saved every CheckpointInterval bytes, so that a
+	backward seek restarts from the nearest checkpoint and not from the
+	beginning of the member.
+
+	As the member is not inflated at once, its errors are only found when
+	the reads reach them: from then on, all the reads fail and the stream
+	is at its end, as if the member had been rejected on opening.
+ */
+class RVNGZipInflateStream : public RVNGInputStream
+{
+public:
+	enum { WindowSize = 1 << 18, HistorySize = 1 << 16, CheckpointInterval = 1 << 20, InputBufferSize = 1 << 16 };
+
+	RVNGZipInflateStream(RVNGInputStream *input, unsigned long dataOffset, unsigned long compressedSize, unsigned long size);
+	~RVNGZipInflateStream();
+
+	//! initializes the inflate state, returns false on error
+	bool init();
+
+	bool isStructured();
+	unsigned subStreamCount();
+	const char *subStreamName(unsigned id);
+	bool existsSubStream(const char *name);
+	RVNGInputStream *getSubStreamByName(const char *name);
+	RVNGInputStream *getSubStreamById(unsigned id);
+	RVNGInputStream *getOnDemandSubStreamByName(const char *name);
+
+	const unsigned char *read(unsigned long numBytes, unsigned long &numBytesRead);
+	int seek(long offset, RVNG_SEEK_TYPE seekType);
+	long tell();
+	bool isEnd();
+	RVNGInputStream *clone() const;
+
+private:
+	//! creates the substream name, reading it on demand if asked
+	RVNGInputStream *getSubStream(const char *name, bool onDemand);
+	struct Checkpoint
 	{
-		if (!readCentralDirectoryEntry(input, entry))
-			return false;
-		if (name_size == entry.filename_size && entry.filename == name)
+		unsigned long m_outPos;
+		unsigned long m_inPos;
+		z_stream m_state;
+	};
+
+	//! saves a copy of the current inflate state
+	void addCheckpoint();
+	//! restarts from the last checkpoint before pos
+	bool restoreCheckpoint(unsigned long pos);
+	//! inflates at most len bytes in data, returns the number of inflated bytes
+	unsigned long inflateData(unsigned char *data, unsigned long len);
+	//! makes the window contain [pos, pos+len) and returns the number of available bytes from pos
+	unsigned long fillWindow(unsigned long pos, unsigned long len);
+	//! called when the data are corrupt or end before the expected size
+	void fail();
+
+	RVNGInputStream *m_input;
+	//! true if the compressed data are read with the positional reads of the input
+	bool m_hasReadAt;
+	unsigned long m_dataOffset;
+	unsigned long m_compressedSize;
+	unsigned long m_size;
+	long m_offset;
+
+	z_stream m_strm;
+	bool m_strmValid;
+	bool m_strmEnd;
+	//! true once the member is known to be corrupt, all the reads fail then
+	bool m_failed;
+	//! the number of compressed bytes already given to zlib
+	unsigned long m_inPos;
+	std::vector<unsigned char> m_inBuffer;
+
+	//! the window, which always ends at the current inflate position
+	std::vector<unsigned char> m_window;
+	unsigned long m_windowStart;
+	unsigned long m_windowLength;
+
+	//! the checkpoints, zlib needs them to stay at the same address
+	std::vector<std::unique_ptr<Checkpoint> > m_checkpoints;
+
+	enum StructureType { Unknown, Flat, OLE2, Zip };
+	StructureType m_structureType;
+	std::vector<std::string> m_streamNameList;
+	std::unique_ptr<Storage> m_storage;
+	std::unique_ptr<RVNGZipDirectory> m_zipDirectory;
+
+	// no copy or assign
+	RVNGZipInflateStream(const RVNGZipInflateStream &);
+	RVNGZipInflateStream &operator=(const RVNGZipInflateStream &);
+};
+
+RVNGZipInflateStream::RVNGZipInflateStream(RVNGInputStream *input, unsigned long dataOffset, unsigned long compressedSize, unsigned long size) :
+	RVNGInputStream(),
+	m_input(input),
+	m_hasReadAt(false),
+	m_dataOffset(dataOffset),
+	m_compressedSize(compressedSize),
+	m_size(size),
+	m_offset(0),
+	m_strm(),
+	m_strmValid(false),
+	m_strmEnd(false),
+	m_failed(false),
+	m_inPos(0),
+	m_inBuffer(InputBufferSize),
+	m_window(),
+	m_windowStart(0),
+	m_windowLength(0),
+	m_checkpoints(),
+	m_structureType(Unknown),
+	m_streamNameList(),
+	m_storage(),
+	m_zipDirectory()
+{
+}
+
+RVNGZipInflateStream::~RVNGZipInflateStream()
+{
+	if (m_strmValid)
+		(void)inflateEnd(&m_strm);
+	for (auto &checkpoint : m_checkpoints)
+		(void)inflateEnd(&checkpoint->m_state);
+}
+
+bool RVNGZipInflateStream::init()
+{
+	m_strm.zalloc = Z_NULL;
+	m_strm.zfree = Z_NULL;
+	m_strm.opaque = Z_NULL;
+	m_strm.avail_in = 0;
+	m_strm.next_in = Z_NULL;
+	if (inflateInit2(&m_strm,-MAX_WBITS) != Z_OK)
+		return false;
+	m_strmValid = true;
+	unsigned char byte = 0;
+	m_hasReadAt = m_compressedSize && m_input->readAt(m_dataOffset, 1, &byte) == 1;
+	addCheckpoint();
+	return !m_checkpoints.empty();
+}
+
+void RVNGZipInflateStream::addCheckpoint()
+{
+	std::unique_ptr<Checkpoint> checkpoint(new Checkpoint());
+	checkpoint->m_outPos = m_strm.total_out;
+	checkpoint->m_inPos = m_strm.total_in;
+	if (inflateCopy(&checkpoint->m_state, &m_strm) != Z_OK)
+		return;
+	m_checkpoints.push_back(std::move(checkpoint));
+}
+
+bool RVNGZipInflateStream::restoreCheckpoint(unsigned long pos)
+{
+	auto it = m_checkpoints.rbegin();
+	while (it != m_checkpoints.rend() && (*it)->m_outPos > pos)
+		++it;
+	if (it == m_checkpoints.rend())
+		return false;
+
+	if (m_strmValid)
+		(void)inflateEnd(&m_strm);
+	m_strmValid = inflateCopy(&m_strm, &(*it)->m_state) == Z_OK;
+	if (!m_strmValid)
+		return false;
+	m_strm.next_in = Z_NULL;
+	m_strm.avail_in = 0;
+	m_inPos = (*it)->m_inPos;
+	m_strmEnd = false;
+	m_windowStart = m_strm.total_out;
+	m_windowLength = 0;
+	return true;
+}
+
+void RVNGZipInflateStream::fail()
+{
+	// like the members inflated at once, a corrupt member gives no data
+	RVNG_DEBUG_MSG(("RVNGZipInflateStream::fail: the member is corrupt at %lu of %lu\n", (unsigned long) m_strm.total_out, m_size));
+	m_failed = true;
+	m_strmEnd = true;
+}
+
+unsigned long RVNGZipInflateStream::inflateData(unsigned char *data, unsigned long len)
+{
+	if (!m_strmValid || m_strmEnd || m_failed || !len)
+		return 0;
+	m_strm.next_out = data;
+	m_strm.avail_out = unsigned(len);
+	while (m_strm.avail_out)
+	{
+		if (!m_strm.avail_in)
+		{
+			if (m_inPos >= m_compressedSize)
+			{
+				fail();
+				break;
+			}
+			unsigned long toRead = m_compressedSize - m_inPos;
+			if (toRead > m_inBuffer.size())
+				toRead = (unsigned long) m_inBuffer.size();
+			unsigned long numBytesRead = 0;
+			if (m_hasReadAt)
+			{
+				// positional reads do not disturb the input, which the
+				// clones of this stream may be reading in other threads
+				numBytesRead = m_input->readAt(m_dataOffset + m_inPos, toRead, m_inBuffer.data());
+			}
+			else
+			{
+				// the input may be used by someone else, so restore its position
+				const long pos = m_input->tell();
+				const unsigned char *buffer = nullptr;
+				if (m_input->seek(long(m_dataOffset + m_inPos), RVNG_SEEK_SET) == 0)
+					buffer = m_input->read(toRead, numBytesRead);
+				if (buffer && numBytesRead)
+					memcpy(m_inBuffer.data(), buffer, size_t(numBytesRead));
+				m_input->seek(pos, RVNG_SEEK_SET);
+				if (!buffer)
+					numBytesRead = 0;
+			}
+			if (!numBytesRead)
+			{
+				fail();
+				break;
+			}
+			m_inPos += numBytesRead;
+			m_strm.next_in = m_inBuffer.data();
+			m_strm.avail_in = unsigned(numBytesRead);
+		}
+		const int ret = inflate(&m_strm, Z_NO_FLUSH);
+		if (ret == Z_STREAM_END && m_strm.total_out == m_size)
+		{
+			m_strmEnd = true;
+			break;
+		}
+		if (ret != Z_OK)
+		{
+			RVNG_DEBUG_MSG(("RVNGZipInflateStream::inflateData: inflate failed with %d\n", ret));
+			fail();
 			break;
+		}
+		if (m_strm.total_out >= m_checkpoints.back()->m_outPos + CheckpointInterval)
+			addCheckpoint();
 	}
-	if (name_size != entry.filename_size)
-		return false;
-	if (entry.filename != name)
+	return len - m_strm.avail_out;
+}
+
+unsigned long RVNGZipInflateStream::fillWindow(unsigned long pos, unsigned long len)
+{
+	if (pos >= m_windowStart && pos + len <= m_windowStart + m_windowLength)
+		return len;
+
+	if (pos < m_windowStart && !restoreCheckpoint(pos))
+		return 0;
+
+	unsigned long current = m_windowStart + m_windowLength;
+	if (pos > current)
+	{
+		// skip the data before pos
+		if (m_window.size() < WindowSize)
+			m_window.resize(WindowSize);
+		while (current < pos)
+		{
+			unsigned long toSkip = pos - current;
+			if (toSkip > m_window.size())
+				toSkip = (unsigned long) m_window.size();
+			const unsigned long skipped = inflateData(m_window.data(), toSkip);
+			if (!skipped)
+				break;
+			current += skipped;
+		}
+		m_windowStart = current;
+		m_windowLength = 0;
+		if (current < pos)
+			return 0;
+	}
+	else
+	{
+		// keep a little data before pos for the small backward seeks
+		unsigned long keep = pos > HistorySize ? pos - HistorySize : 0;
+		if (keep < m_windowStart)
+			keep = m_windowStart;
+		if (keep > m_windowStart)
+		{
+			memmove(m_window.data(), m_window.data() + (keep - m_windowStart), size_t(current - keep));
+			m_windowLength = current - keep;
+			m_windowStart = keep;
+		}
+	}
+
+	unsigned long needed = pos + len - m_windowStart;
+	if (m_window.size() < needed || m_window.size() < WindowSize)
+		m_window.resize(needed > (unsigned long) WindowSize ? needed : (unsigned long) WindowSize);
+	while (m_windowLength < needed)
+	{
+		unsigned long toInflate = (unsigned long) m_window.size() - m_windowLength;
+		if (toInflate > m_size - (m_windowStart + m_windowLength))
+			toInflate = m_size - (m_windowStart + m_windowLength);
+		const unsigned long inflated = inflateData(m_window.data() + m_windowLength, toInflate);
+		if (!inflated)
+			break;
+		m_windowLength += inflated;
+	}
+	if (m_windowStart + m_windowLength <= pos)
+		return 0;
+	const unsigned long available = m_windowStart + m_windowLength - pos;
+	return available < len ? available : len;
+}
+
+const unsigned char *RVNGZipInflateStream::read(unsigned long numBytes, unsigned long &numBytesRead)
+{
+	numBytesRead = 0;
+
+	if (numBytes == 0 || m_failed || m_offset < 0 || (unsigned long) m_offset >= m_size)
+		return nullptr;
+
+	auto pos = (unsigned long) m_offset;
+	if (numBytes > m_size - pos)
+		numBytes = m_size - pos;
+	numBytes = fillWindow(pos, numBytes);
+	if (!numBytes || m_failed)
+		return nullptr;
+
+	m_offset += long(numBytes);
+	numBytesRead = numBytes;
+	return m_window.data() + (pos - m_windowStart);
+}
+
+int RVNGZipInflateStream::seek(long offset, RVNG_SEEK_TYPE seekType)
+{
+	if (seekType == RVNG_SEEK_CUR)
+		m_offset += offset;
+	else if (seekType == RVNG_SEEK_SET)
+		m_offset = offset;
+	else if (seekType == RVNG_SEEK_END)
+		m_offset = long(m_size) + offset;
+
+	if (m_offset < 0)
+	{
+		m_offset = 0;
+		return -1;
+	}
+	if (m_offset > long(m_size))
+	{
+		m_offset = long(m_size);
+		return -1;
+	}
+
+	return 0;
+}
+
+long RVNGZipInflateStream::tell()
+{
+	return m_offset;
+}
+
+bool RVNGZipInflateStream::isEnd()
+{
+	return m_failed || m_offset >= long(m_size);
+}
+
+RVNGInputStream *RVNGZipInflateStream::clone() const
+{
+	// without positional reads, the clone would move the shared input
+	if (!m_hasReadAt)
+		return nullptr;
+	// the clone inflates the data again, with its own state and window
+	std::unique_ptr<RVNGZipInflateStream> stream(new RVNGZipInflateStream(m_input, m_dataOffset, m_compressedSize, m_size));
+	if (!stream->init())
+		return nullptr;
+	return stream.release();
+}
+
+bool RVNGZipInflateStream::isStructured()
+{
+	if (!m_size)
 		return false;
-	input->seek(entry.offset, RVNG_SEEK_SET);
-	LocalFileHeader header;
-	if (!readLocalFileHeader(input, header))
+
+	if (m_structureType == Unknown)
+	{
+		seek(0, RVNG_SEEK_SET);
+
+		// Check whether it is OLE2 storage
+		std::unique_ptr<Storage> tmpStorage(new Storage(this));
+		if (tmpStorage->isStructured())
+		{
+			m_structureType = OLE2;
+			m_streamNameList = tmpStorage->getSubStreamNamesList();
+			m_storage = std::move(tmpStorage);
+			return true;
+		}
+		seek(0, RVNG_SEEK_SET);
+		std::unique_ptr<RVNGZipDirectory> tmpDirectory(new RVNGZipDirectory());
+		if (RVNGZipStream::isZipFile(this) && tmpDirectory->load(this))
+		{
+			m_structureType = Zip;
+			m_streamNameList = tmpDirectory->getSubStreamNamesList();
+			m_zipDirectory = std::move(tmpDirectory);
+			return true;
+		}
+		m_structureType = Flat;
 		return false;
-	if (!areHeadersConsistent(header, entry))
+	}
+	return m_structureType != Flat;
+}
+
+unsigned RVNGZipInflateStream::subStreamCount()
+{
+	if (!isStructured()) return 0;
+	return (unsigned) m_streamNameList.size();
+}
+
+const char *RVNGZipInflateStream::subStreamName(unsigned id)
+{
+	if (!isStructured() || id >= (unsigned) m_streamNameList.size())
+		return nullptr;
+	return m_streamNameList[size_t(id)].c_str();
+}
+
+bool RVNGZipInflateStream::existsSubStream(const char *name)
+{
+	if (!name || !isStructured())
 		return false;
-	return true;
+	for (const auto &i : m_streamNameList)
+	{
+		if (i == name)
+			return true;
+	}
+	return false;
+}
+
+RVNGInputStream *RVNGZipInflateStream::getSubStreamById(unsigned id)
+{
+	return getSubStreamByName(subStreamName(id));
+}
+
+RVNGInputStream *RVNGZipInflateStream::getSubStreamByName(const char *name)
+{
+	return getSubStream(name, false);
+}
+
+RVNGInputStream *RVNGZipInflateStream::getOnDemandSubStreamByName(const char *name)
+{
+	return getSubStream(name, true);
+}
+
+RVNGInputStream *RVNGZipInflateStream::getSubStream(const char *name, bool onDemand)
+{
+	if (!name || !isStructured())
+		return nullptr;
+	if (m_structureType == OLE2)
+		return m_storage ? m_storage->getSubStream(name, onDemand) : nullptr;
+	if (m_structureType == Zip)
+		return m_zipDirectory ? m_zipDirectory->getSubstream(this, name, onDemand) : nullptr;
+	return nullptr;
+}
+
+//! the members bigger than this are inflated on demand, when it is asked
+#define ZIP_INFLATE_ON_DEMAND_SIZE (1 << 22)
+
+static RVNGInputStream *getSubstreamFromEntry(RVNGInputStream *input, CentralDirectoryEntry const &entry, bool onDemand)
+{
+	if (!findDataStream(input, entry))
+		return nullptr;
+	if (!entry.compressed_size)
+		return nullptr;
+	if (onDemand && entry.compression && entry.uncompressed_size >= ZIP_INFLATE_ON_DEMAND_SIZE)
+	{
+		const long dataOffset = input->tell();
+		if (dataOffset < 0 || input->seek(long(entry.compressed_size), RVNG_SEEK_CUR) != 0)
+			return nullptr;
+		std::unique_ptr<RVNGZipInflateStream> stream(new RVNGZipInflateStream(input, (unsigned long) dataOffset, entry.compressed_size, entry.uncompressed_size));
+		if (!stream->init())
+			return nullptr;
+		return stream.release();
+	}
+	if (!entry.compression)
+	{
+		// a stored member of a memory-backed zip file can simply reference its data
+		const long dataOffset = input->tell();
+		std::shared_ptr<const unsigned char> slice;
+		if (dataOffset >= 0)
+			slice = RVNGStreamBuffer::getSlice(input, (unsigned long) dataOffset, entry.compressed_size);
+		if (slice)
+			return RVNGStreamBuffer::createStream(slice, entry.compressed_size);
+	}
+	unsigned long numBytesRead = 0;
+	const unsigned char *compressedData = input->read(entry.compressed_size, numBytesRead);
+	if (numBytesRead != entry.compressed_size)
+		return nullptr;
+	if (!entry.compression)
+		return new RVNGStringStream(compressedData, (unsigned)numBytesRead);
+
+	std::vector<unsigned char> data;
+	if (RVNGInflate::inflateBuffer(compressedData, numBytesRead, true, entry.uncompressed_size, data) != RVNGInflate::Done)
+		return nullptr; // abandon partial result
+	if (data.empty())
+		return nullptr;
+	return RVNGStreamBuffer::createStream(std::move(data));
 }
 
 static std::vector<std::string> getSubStreamNamesInZip(RVNGInputStream *input, bool all=false)
@@ -397,6 +884,21 @@ static std::vector<std::string> getSubStreamNamesInZip(RVNGInputStream *input, b
 }
 } // anonymous namespace
 
+class RVNGZipDirectoryPrivate
+{
+public:
+	RVNGZipDirectoryPrivate() : m_names(), m_entries()
+	{
+	}
+	//! the member names, directories excepted
+	std::vector<std::string> m_names;
+	//! the central directory entries by name
+	std::unordered_map<std::string, CentralDirectoryEntry> m_entries;
+private:
+	RVNGZipDirectoryPrivate(const RVNGZipDirectoryPrivate &);
+	RVNGZipDirectoryPrivate &operator=(const RVNGZipDirectoryPrivate &);
+};
+
 bool RVNGZipStream::isZipFile(RVNGInputStream *input)
 {
 	// look for central directory end
@@ -427,72 +929,63 @@ std::vector<std::string> RVNGZipStream::getSubStreamNamesList(RVNGInputStream *i
 
 RVNGInputStream *RVNGZipStream::getSubstream(RVNGInputStream *input, const char *name)
 {
-	CentralDirectoryEntry entry;
-	if (!findDataStream(input, entry, name))
-		return nullptr;
-	if (!entry.compressed_size)
+	RVNGZipDirectory directory;
+	if (!directory.load(input))
 		return nullptr;
-	unsigned long numBytesRead = 0;
-	auto *compressedData = const_cast<unsigned char *>(input->read(entry.compressed_size, numBytesRead));
-	if (numBytesRead != entry.compressed_size)
-		return nullptr;
-	if (!entry.compression)
-		return new RVNGStringStream(compressedData, (unsigned)numBytesRead);
-	else
-	{
-		int ret;
-		z_stream strm;
-
-		/* allocate inflate state */
-		strm.zalloc = Z_NULL;
-		strm.zfree = Z_NULL;
-		strm.opaque = Z_NULL;
-		strm.avail_in = 0;
-		strm.next_in = Z_NULL;
-		ret = inflateInit2(&strm,-MAX_WBITS);
-		if (ret != Z_OK)
-			return nullptr;
-
-		const unsigned long blockSize = (std::max)(4096ul, 2 * numBytesRead);
-
-		std::vector<unsigned char> data(blockSize);
-
-		strm.avail_in = (unsigned)numBytesRead;
-		strm.next_in = (Bytef *)compressedData;
-		strm.next_out = data.data();
+	return directory.getSubstream(input, name);
+}
 
-		bool done = false;
-		while (!done)
-		{
-			const std::ptrdiff_t nextOutIndex = strm.next_out - data.data();
-			assert(nextOutIndex >= 0);
-			data.resize(data.size() + blockSize);
-			assert(data.size() > std::size_t(nextOutIndex));
-			strm.avail_out = unsigned(data.size() - std::size_t(nextOutIndex));
-			strm.next_out = reinterpret_cast<Bytef *>(&data[nextOutIndex]);
+RVNGZipDirectory::RVNGZipDirectory() :
+	m_d(new RVNGZipDirectoryPrivate())
+{
+}
 
-			ret = inflate(&strm, Z_SYNC_FLUSH);
+RVNGZipDirectory::~RVNGZipDirectory()
+{
+}
 
-			switch (ret)
-			{
-			case Z_OK:
-				break;
-			// TODO: return partial result on Z_BUF_ERROR/Z_DATA_ERROR?
-			default:
-				strm.total_out = 0; // abandon partial result
-			/* FALLTHRU */
-			case Z_STREAM_END:
-				done = true;
-				break;
-			}
-		}
+bool RVNGZipDirectory::load(RVNGInputStream *input)
+{
+	m_d->m_names.clear();
+	m_d->m_entries.clear();
+	if (!input || !findCentralDirectoryEnd(input))
+		return false;
+	CentralDirectoryEnd end;
+	if (!readCentralDirectoryEnd(input, end))
+		return false;
+	input->seek(long(end.cdir_offset), RVNG_SEEK_SET);
+	while (!input->isEnd() && (unsigned)input->tell() < end.cdir_offset + end.cdir_size)
+	{
+		CentralDirectoryEntry entry;
+		if (!readCentralDirectoryEntry(input, entry))
+			break;
+		if (!entry.filename_size)
+			continue;
+		// A file name with a \0 char in it is likely broken. Anyway, our char*-based
+		// interface cannot handle such names, so we just ignore them.
+		if (entry.filename.find('\0') != std::string::npos)
+			continue;
+		if (entry.filename[entry.filename.size()-1] != '/')
+			m_d->m_names.push_back(entry.filename);
+		// like a linear search, the first entry with a given name wins
+		m_d->m_entries.insert(std::make_pair(entry.filename, entry));
+	}
+	return true;
+}
 
-		(void)inflateEnd(&strm);
+std::vector<std::string> const &RVNGZipDirectory::getSubStreamNamesList() const
+{
+	return m_d->m_names;
+}
 
-		if (strm.total_out == 0)
-			return nullptr;
-		return new RVNGStringStream(data.data(), (unsigned int) strm.total_out);
-	}
+RVNGInputStream *RVNGZipDirectory::getSubstream(RVNGInputStream *input, const char *name, bool onDemand) const
+{
+	if (!input || !name)
+		return nullptr;
+	auto it = m_d->m_entries.find(name);
+	if (it == m_d->m_entries.end())
+		return nullptr;
+	return getSubstreamFromEntry(input, it->second, onDemand);
 }
 
 }
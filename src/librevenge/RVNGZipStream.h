@@ -20,6 +20,7 @@
 #ifndef RVNGZIPSTREAM_H
 #define RVNGZIPSTREAM_H
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -37,6 +38,38 @@ public:
 	static RVNGInputStream *getSubstream(RVNGInputStream *input, const char *name);
 };
 
+class RVNGZipDirectoryPrivate;
+
+/** The central directory of a zip file.
+
+	It is read once, by load(), and kept by the stream owning the zip
+	data, so that opening a member does not need to scan the archive.
+ */
+class RVNGZipDirectory
+{
+public:
+	RVNGZipDirectory();
+	~RVNGZipDirectory();
+
+	/** reads the central directory of input, returns false if it can not be found */
+	bool load(RVNGInputStream *input);
+	/** returns the names of the members which are not directories */
+	std::vector<std::string> const &getSubStreamNamesList() const;
+	/** creates a stream with the content of the member name, or returns 0.
+
+		If onDemand is true, the big deflated members are inflated when
+		they are read, so the result must not outlive input.
+	 */
+	RVNGInputStream *getSubstream(RVNGInputStream *input, const char *name, bool onDemand = false) const;
+
+private:
+	std::unique_ptr<RVNGZipDirectoryPrivate> m_d;
+
+	// no copy or assign
+	RVNGZipDirectory(const RVNGZipDirectory &);
+	RVNGZipDirectory &operator=(const RVNGZipDirectory &);
+};
+
 }
 
 #endif // RVNGZIPSTREAM_H